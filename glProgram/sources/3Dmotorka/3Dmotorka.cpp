@@ -364,12 +364,9 @@ struct VertexData {
 //---------------------------
 class ParamSurface : public Geometry<VertexData> {
 	//---------------------------
-	unsigned int nVtxPerStrip, nStrips;
 public:
 	ParamSurface()
 	{
-		nVtxPerStrip = nStrips = 0;
-	
 		// Enable the vertex attribute arrays
 		glEnableVertexAttribArray(0);  // attribute array 0 = POSITION
 		glEnableVertexAttribArray(1);  // attribute array 1 = NORMAL
@@ -395,21 +392,18 @@ public:
 	}
 
 	void create(int N = tessellationLevel, int M = tessellationLevel) {
-		nVtxPerStrip = (M + 1) * 2;
-		nStrips = N;
 		vtx.clear();
-		for (int i = 0; i < N; i++) {
+		for (int i = 0; i <= N; i++) {
 			for (int j = 0; j <= M; j++) {
 				vtx.push_back(GenVertexData((float)j / M, (float)i / N));
-				vtx.push_back(GenVertexData((float)j / M, (float)(i + 1) / N));
 			}
 		}
+		GridStrips(N, M); // every grid vertex once, the strips index them
 		updateGPU();
 	}
 
 	void Draw() {
-		Bind();
-		for (unsigned int i = 0; i < nStrips; i++) glDrawArrays(GL_TRIANGLE_STRIP, i * nVtxPerStrip, nVtxPerStrip);
+		DrawStrips();
 	}
 };
 
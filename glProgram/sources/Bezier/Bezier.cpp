@@ -2,6 +2,8 @@
 // Bezier Curve
 //=============================================================================================
 #include "framework.h"
+#include <chrono>
+#include <random>
 
 // cscspont rnyal
 const char* vertSource = R"(
@@ -30,29 +32,285 @@ const char* fragSource = R"(
 	}
 )";
 
+// curve vertex shader: the curve from the control points in a texture buffer, gl_VertexID is the sample
+const char* curveVertSource = R"(
+	#version 330
+    precision highp float;
+
+	uniform samplerBuffer controlPoints;	// xy
+	uniform int nControlPoints, nSamples;
+
+	void main()
+	{
+		int n = nControlPoints - 1;
+		vec2 r = texelFetch(controlPoints, gl_VertexID == 0 ? 0 : n).xy;
+		if (gl_VertexID > 0 && gl_VertexID < nSamples - 1)
+		{
+			// B_i(t) = C(n, i) t^i (1 - t)^(n - i) in logarithms, so high degrees do not overflow
+			float t = float(gl_VertexID) / float(nSamples - 1);
+			float logT = log(t), log1T = log(1.0 - t), logC = 0.0;
+			r = vec2(0, 0);
+			for (int i = 0; i <= n; i++)
+			{
+				if (i > 0) logC += log(float(n - i + 1) / float(i));
+				r += exp(logC + float(i) * logT + float(n - i) * log1T) * texelFetch(controlPoints, i).xy;
+			}
+		}
+		gl_Position = vec4(r, 0, 1);
+	}
+)";
+
 const int winWidth = 600, winHeight = 600;
 
+// the original evaluation with binomials and pow for every control point at every sample, O(n^2),
+// kept as reference for the benchmark
+vec2 BezierPow(const std::vector<vec2>& cps, float t)
+{
+	vec2 rt(0, 0);
+	for (int i = 0; i < cps.size(); i++)
+	{
+		float choose = 1;
+		for (int j = 1; j <= i; j++)
+			choose *= (float)(cps.size() - j) / j;
+		float B = choose * pow(t, i) * pow(1 - t, cps.size() - 1 - i);
+		rt += cps[i] * B;
+	}
+	return rt;
+}
+
+// samples at the uniform parameters t = s / (nSamples - 1) of a Bezier curve
+class BezierEvaluator
+{
+	static const int maxForwardDegree = 4; // the error of forward differencing grows like nSamples^degree
+
+	int degree = -1, nSamples = 0, stride = 0;	// the table is for this degree and tessellation
+	std::vector<float> basis;			// basis[i * stride + s] = B_i(t_s), the samples padded to a multiple of 4
+	std::vector<int> rowBegin, rowEnd;	// the range of s where B_i is not negligible, multiples of 4
+	std::vector<float> x, y;			// sums of the samples
+	std::vector<vec2> work;
+	std::vector<dvec2> differences;
+	std::vector<double> logFactorial;	// logFactorial[i] = log i!, grown on demand
+
+	void GrowLogFactorial(int n)
+	{
+		for (int i = (int)logFactorial.size(); i <= n; i++) logFactorial.push_back(lgamma(i + 1.0));
+	}
+
+	void BuildTable(int n, int samples)
+	{
+		degree = n;
+		nSamples = samples;
+		stride = (samples + 3) & ~3;
+		basis.assign((size_t)(n + 1) * stride, 0.0f);
+		rowBegin.assign(n + 1, stride);
+		rowEnd.assign(n + 1, 0);
+
+		// in logarithms, log B_i(t) = log C(n, i) + i log t + (n - i) log(1 - t), so nothing overflows at any degree
+		GrowLogFactorial(n);
+		const double logNegligible = log(1e-10); // far below the float resolution of the sum
+		for (int s = 0; s < samples; s++)
+		{
+			double t = samples > 1 ? (double)s / (samples - 1) : 0.0;
+			double logT = log(t), log1T = log(1.0 - t);
+			for (int i = 0; i <= n; i++)
+			{
+				double logB = logFactorial[n] - logFactorial[i] - logFactorial[n - i] + (i > 0 ? i * logT : 0.0) + (i < n ? (n - i) * log1T : 0.0);
+				if (logB < logNegligible) continue;
+				basis[(size_t)i * stride + s] = (float)exp(logB);
+				rowBegin[i] = min(rowBegin[i], s & ~3);
+				rowEnd[i] = max(rowEnd[i], (s + 4) & ~3);
+			}
+		}
+	}
+
+public:
+	// one point by repeated linear interpolation: only convex combinations, stable at any degree, O(n^2)
+	vec2 DeCasteljau(const std::vector<vec2>& cps, float t)
+	{
+		work = cps;
+		for (int k = (int)work.size() - 1; k > 0; k--)
+			for (int i = 0; i < k; i++)
+				work[i] = mix(work[i], work[i + 1], t);
+		return work[0];
+	}
+
+	// one point as the Bernstein sum, O(n) at most: the terms are unimodal in i, so the sum starts at the
+	// largest one, which is computed in logarithms, and walks outwards with the ratio of the neighbouring
+	// terms until they are negligible; nothing overflows at any degree
+	vec2 Bernstein(const std::vector<vec2>& cps, float t)
+	{
+		int n = (int)cps.size() - 1;
+		if (t <= 0.0f) return cps.front();
+		if (t >= 1.0f) return cps.back();
+		GrowLogFactorial(n);
+
+		const double negligible = 1e-10; // as in the basis table
+		double u = t, odds = u / (1.0 - u);
+		int mode = min((int)((n + 1) * u), n);
+		double bMode = exp(logFactorial[n] - logFactorial[mode] - logFactorial[n - mode] + mode * log(u) + (n - mode) * log1p(-u));
+		dvec2 sum = dvec2(cps[mode]) * bMode;
+		double b = bMode;
+		for (int i = mode; i < n && b >= negligible; i++) // B_i+1 = B_i (n - i) / (i + 1) t / (1 - t)
+		{
+			b *= (n - i) / (i + 1.0) * odds;
+			sum += dvec2(cps[i + 1]) * b;
+		}
+		b = bMode;
+		for (int i = mode; i > 0 && b >= negligible; i--)
+		{
+			b *= i / ((n - i + 1.0) * odds);
+			sum += dvec2(cps[i - 1]) * b;
+		}
+		return vec2(sum);
+	}
+
+	void DeCasteljau(const std::vector<vec2>& cps, int samples, std::vector<vec2>& out)
+	{
+		out.resize(samples);
+		for (int s = 0; s < samples; s++)
+			out[s] = DeCasteljau(cps, samples > 1 ? (float)s / (samples - 1) : 0.0f);
+	}
+
+	// the Bernstein polynomials are tabulated once per degree and tessellation, then every sample is
+	// a weighted sum of the control points over the basis functions that are not negligible there, O(n) per sample
+	void BasisTable(const std::vector<vec2>& cps, int samples, std::vector<vec2>& out)
+	{
+		int n = (int)cps.size() - 1;
+		if (n != degree || samples != nSamples) BuildTable(n, samples);
+		x.assign(stride, 0.0f);
+		y.assign(stride, 0.0f);
+		for (int i = 0; i <= n; i++)
+		{
+			const float* b = &basis[(size_t)i * stride];
+#ifdef FRAMEWORK_SSE2
+			__m128 px = _mm_set1_ps(cps[i].x), py = _mm_set1_ps(cps[i].y);
+			for (int s = rowBegin[i]; s < rowEnd[i]; s += 4)
+			{
+				__m128 w = _mm_loadu_ps(b + s);
+				_mm_storeu_ps(&x[s], _mm_add_ps(_mm_loadu_ps(&x[s]), _mm_mul_ps(w, px)));
+				_mm_storeu_ps(&y[s], _mm_add_ps(_mm_loadu_ps(&y[s]), _mm_mul_ps(w, py)));
+			}
+#else
+			for (int s = rowBegin[i]; s < rowEnd[i]; s++)
+			{
+				x[s] += b[s] * cps[i].x;
+				y[s] += b[s] * cps[i].y;
+			}
+#endif
+		}
+		out.resize(samples);
+		for (int s = 0; s < samples; s++) out[s] = vec2(x[s], y[s]);
+	}
+
+	// the first degree + 1 samples give the forward differences at t = 0, the last one is constant,
+	// then every sample takes degree additions; in double, and only for low degrees
+	void ForwardDifferences(const std::vector<vec2>& cps, int samples, std::vector<vec2>& out)
+	{
+		int n = (int)cps.size() - 1;
+		differences.resize(n + 1);
+		for (int k = 0; k <= n; k++)
+		{
+			double t = (double)k / (samples - 1);
+			std::vector<dvec2> d(cps.begin(), cps.end());
+			for (int m = n; m > 0; m--)
+				for (int i = 0; i < m; i++)
+					d[i] = mix(d[i], d[i + 1], t);
+			differences[k] = d[0];
+		}
+		for (int k = 1; k <= n; k++)
+			for (int i = n; i >= k; i--)
+				differences[i] -= differences[i - 1];
+
+		out.resize(samples);
+		for (int s = 0; s < samples; s++)
+		{
+			out[s] = vec2(differences[0]);
+			for (int k = 0; k < n; k++) differences[k] += differences[k + 1];
+		}
+	}
+
+	// forward differences where they are accurate enough, the basis table otherwise
+	void Evaluate(const std::vector<vec2>& cps, int samples, std::vector<vec2>& out)
+	{
+		if (cps.empty()) { out.clear(); return; }
+		if ((int)cps.size() - 1 <= maxForwardDegree && samples > (int)cps.size()) ForwardDifferences(cps, samples, out);
+		else BasisTable(cps, samples, out);
+	}
+
+	// a single point: de Casteljau is O(n^2), so only for low degrees
+	vec2 Evaluate(const std::vector<vec2>& cps, float t)
+	{
+		return ((int)cps.size() - 1 <= maxForwardDegree) ? DeCasteljau(cps, t) : Bernstein(cps, t);
+	}
+};
+
 const int nTessVertices = 500;
+
+// adaptive: screen space adaptive tessellation, uniform: nTessVertices + 1 samples on the CPU,
+// gpu: only the control points are uploaded, the vertex shader evaluates the samples
+enum Tessellation { TESSELLATION_ADAPTIVE, TESSELLATION_UNIFORM, TESSELLATION_GPU };
+const char* tessellationNames[] = { "adaptive", "uniform", "GPU" };
+
 class Bezier
 {
 	Geometry<vec2>* controlPoints;
 	Geometry<vec2>* curvePoints;
 
 	vec2* selectedPoint = nullptr;
+	BezierEvaluator evaluator;
+	Tessellation tessellation = TESSELLATION_ADAPTIVE;
+	CurveTessellator tessellator;
+
+	TextureBuffer* gpuControlPoints;
+	std::vector<vec4> gpuData;
+	unsigned int emptyVao;	// the GPU samples have no attributes
+	int nGpuSamples = nTessVertices + 1;
 
 public:
-	Bezier() { controlPoints = new Geometry<vec2>(); curvePoints = new Geometry<vec2>(); }
-	~Bezier() { delete controlPoints; delete curvePoints; }
+	Bezier()
+	{
+		controlPoints = new Geometry<vec2>(); curvePoints = new Geometry<vec2>();
+		gpuControlPoints = new TextureBuffer();
+		glGenVertexArrays(1, &emptyVao);
+	}
+	~Bezier() { delete controlPoints; delete curvePoints; delete gpuControlPoints; glDeleteVertexArrays(1, &emptyVao); }
 
 	void AddControlPoint(vec2 cp)
 	{
 		controlPoints->Vtx().push_back(cp);
 		controlPoints->updateGPU();
 		Recalculate();
+		if (tessellation == TESSELLATION_ADAPTIVE)
+			printf("%d curve vertices, %d evaluations\n", tessellator.VertexCount(), tessellator.Evaluations());
+	}
+	Tessellation GetTessellation() const { return tessellation; }
+	int SetTessellation(Tessellation _tessellation) // returns the new vertex count
+	{
+		tessellation = _tessellation;
+		Recalculate();
+		return tessellation == TESSELLATION_GPU ? nGpuSamples : (int)curvePoints->Vtx().size();
+	}
+	// GPU samples, no CPU work
+	int ScaleGpuSamples(float factor)
+	{
+		nGpuSamples = clamp((int)(nGpuSamples * factor), 2, 1 << 20);
+		return nGpuSamples;
 	}
-	void Render(GPUProgram* gpuProgram)
+	void Render(GPUProgram* gpuProgram, GPUProgram* curveProgram)
 	{
-		if (controlPoints->Vtx().size() >= 2)
+		if (controlPoints->Vtx().size() >= 2 && tessellation == TESSELLATION_GPU)
+		{
+			curveProgram->Use();
+			gpuControlPoints->Bind(0);
+			curveProgram->setUniform(0, "controlPoints");
+			curveProgram->setUniform((int)controlPoints->Vtx().size(), "nControlPoints");
+			curveProgram->setUniform(nGpuSamples, "nSamples");
+			curveProgram->setUniform(vec3(1.0f, 1.0f, 0.0f), "color");
+			glBindVertexArray(emptyVao);
+			glDrawArrays(GL_LINE_STRIP, 0, nGpuSamples);
+			gpuProgram->Use();
+		}
+		else if (controlPoints->Vtx().size() >= 2)
 			curvePoints->Draw(gpuProgram, GL_LINE_STRIP, { 1.0f, 1.0f, 0.0f });
 
 		if (controlPoints->Vtx().size() == 0)
@@ -100,6 +358,13 @@ public:
 private:
 	void Recalculate()
 	{
+		if (tessellation == TESSELLATION_GPU) // a few bytes per control point
+		{
+			gpuData.resize(controlPoints->Vtx().size());
+			for (int i = 0; i < gpuData.size(); i++) gpuData[i] = vec4(controlPoints->Vtx()[i], 0, 0);
+			gpuControlPoints->updateGPU(gpuData);
+			return;
+		}
 		curvePoints->Vtx() = GenerateVertices();
 		if (curvePoints->Vtx().size() >= 2)
 			curvePoints->updateGPU();
@@ -108,45 +373,31 @@ private:
 	std::vector<vec2> GenerateVertices()
 	{
 		std::vector<vec2> vertices;
-		for (int i = 0; i <= nTessVertices; ++i)
-		{
-			float t = (float)i / nTessVertices;
-			vertices.push_back(r(t));
-		}
-		return vertices;
-	}
-	vec2 r(float t)
-	{
-		vec2 rt(0, 0);
 		const auto& cps = controlPoints->Vtx();
-		for (int i = 0; i < cps.size(); i++)
-			rt += cps[i] * B(i, t);
-
-		return rt;
-	}
-	float B(int i, float t)
-	{
-		float choose = 1;
-		const auto& cps = controlPoints->Vtx();
-		for (int j = 1; j <= i; j++)
-			choose *= (float)(cps.size() - j) / j;
-		return choose * pow(t, i) * pow(1 - t, cps.size() - 1 - i);
+		if (tessellation == TESSELLATION_ADAPTIVE && cps.size() >= 2)
+			tessellator.Tessellate([&](float t) { return evaluator.Evaluate(cps, t); }, 0.0f, 1.0f,
+				scale(vec3(winWidth / 2.0f, winHeight / 2.0f, 1.0f)), vertices);
+		else
+			evaluator.Evaluate(cps, nTessVertices + 1, vertices);
+		return vertices;
 	}
 };
 
 class BezierApp : public glApp {
 	Bezier* curve;
 	GPUProgram* gpuProgram;
+	GPUProgram* curveProgram;
 
 public:
 	BezierApp() : glApp("Bezier Curve") {}
-	~BezierApp() { delete gpuProgram; delete curve; }
+	~BezierApp() { delete gpuProgram; delete curveProgram; delete curve; }
 
 	void onInitialization() override
 	{
 		glPointSize(10);
 		glLineWidth(3);
 
+		curveProgram = new GPUProgram(curveVertSource, fragSource);
 		gpuProgram = new GPUProgram(vertSource, fragSource);
 		curve = new Bezier;
 	}
@@ -157,7 +408,54 @@ public:
 		glClear(GL_COLOR_BUFFER_BIT);
 		glViewport(0, 0, winWidth, winHeight);
 
-		curve->Render(gpuProgram);
+		curve->Render(gpuProgram, curveProgram);
+	}
+
+	// t: next tessellation, +/-: GPU sample count, b: benchmark of the evaluators on curves of 4 and 300 random control points
+	void onKeyboard(int key) override
+	{
+		if (key == 't')
+		{
+			int nVertices = curve->SetTessellation((Tessellation)((curve->GetTessellation() + 1) % 3));
+			printf("%s tessellation: %d curve vertices\n", tessellationNames[curve->GetTessellation()], nVertices);
+			refreshScreen();
+		}
+		if ((key == '+' || key == '-') && curve->GetTessellation() == TESSELLATION_GPU)
+		{
+			printf("%d GPU samples\n", curve->ScaleGpuSamples(key == '+' ? 2.0f : 0.5f));
+			refreshScreen();
+		}
+		if (key != 'b')
+			return;
+
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+		BezierEvaluator evaluator;
+		std::vector<vec2> samples;
+		const int nSamples = nTessVertices + 1, nRuns = 10;
+		for (int n : { 4, 300 })
+		{
+			std::vector<vec2> cps(n);
+			for (auto& p : cps) p = vec2(coord(rng), coord(rng));
+			auto measure = [&](const char* name, auto evaluate) {
+				auto start = std::chrono::high_resolution_clock::now();
+				for (int r = 0; r < nRuns; r++) evaluate();
+				auto end = std::chrono::high_resolution_clock::now();
+				printf("  %s: %.3f ms\n", name, std::chrono::duration<float, std::milli>(end - start).count() / nRuns);
+			};
+			printf("%d control points, %d samples\n", n, nSamples);
+			measure("binomials and pow", [&] {
+				samples.resize(nSamples);
+				for (int s = 0; s < nSamples; s++) samples[s] = BezierPow(cps, (float)s / (nSamples - 1));
+			});
+			measure("de Casteljau", [&] { evaluator.DeCasteljau(cps, nSamples, samples); });
+			measure("Bernstein sum per point", [&] {
+				samples.resize(nSamples);
+				for (int s = 0; s < nSamples; s++) samples[s] = evaluator.Bernstein(cps, (float)s / (nSamples - 1));
+			});
+			measure("basis table", [&] { evaluator.BasisTable(cps, nSamples, samples); });
+			if (n <= 5) measure("forward differences", [&] { evaluator.ForwardDifferences(cps, nSamples, samples); });
+		}
 	}
 
 	void onMousePressed(MouseButton but, int pX, int pY) override
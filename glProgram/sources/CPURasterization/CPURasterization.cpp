@@ -0,0 +1,791 @@
+//=============================================================================================
+// CPU Rasterization - software 3D pipeline for the parametric surfaces, without OpenGL
+//=============================================================================================
+// The scenes of the ParamSurfaces, 3Dmotorka, Flag3D and PerlinNoise3D demos go through a C++
+// version of the GPU pipeline: vertex shader, homogeneous clipping, tiled half-space rasterization
+// (the core of Rasterization, see rasterizer.h) with a depth buffer and perspective-correct
+// interpolation, then a Phong fragment shader. Only the Phong shading of the demos is ported:
+// the Gouraud and NPR rows and the point textures of 3Dmotorka are left out (every object gets
+// its own diffuse color instead), and the Perlin terrain is generated once, not every frame.
+// No window or GL context is needed, so it also runs on machines without a GPU.
+//
+// Usage: CPURasterization [-o dir] [-n frames] [-t threads]
+//   renders every scene for n frames of a full turn, prints the time per frame and
+//   writes the first frame of each scene to dir/<scene>.png
+#include "framework.h"
+#include "rasterizer.h"
+#include <string.h>
+#include <memory>
+#include <chrono>
+
+//---------------------------
+template<class T> struct Dnum { // Dual numbers for automatic derivation
+	//---------------------------
+	float f; // function value
+	T d;  // derivatives
+	Dnum(float f0 = 0, T d0 = T(0)) { f = f0, d = d0; }
+	Dnum operator+(Dnum r) { return Dnum(f + r.f, d + r.d); }
+	Dnum operator-(Dnum r) { return Dnum(f - r.f, d - r.d); }
+	Dnum operator*(Dnum r) {
+		return Dnum(f * r.f, f * r.d + d * r.f);
+	}
+	Dnum operator/(Dnum r) {
+		return Dnum(f / r.f, (r.f * d - r.d * f) / r.f / r.f);
+	}
+};
+
+// Elementary functions prepared for the chain rule as well
+template<class T> Dnum<T> Exp(Dnum<T> g) { return Dnum<T>(expf(g.f), expf(g.f) * g.d); }
+template<class T> Dnum<T> Sin(Dnum<T> g) { return  Dnum<T>(sinf(g.f), cosf(g.f) * g.d); }
+template<class T> Dnum<T> Cos(Dnum<T>  g) { return  Dnum<T>(cosf(g.f), -sinf(g.f) * g.d); }
+template<class T> Dnum<T> Tan(Dnum<T>  g) { return Sin(g) / Cos(g); }
+template<class T> Dnum<T> Sinh(Dnum<T> g) { return  Dnum<T>(sinh(g.f), cosh(g.f) * g.d); }
+template<class T> Dnum<T> Cosh(Dnum<T> g) { return  Dnum<T>(cosh(g.f), sinh(g.f) * g.d); }
+template<class T> Dnum<T> Tanh(Dnum<T> g) { return Sinh(g) / Cosh(g); }
+template<class T> Dnum<T> Log(Dnum<T> g) { return  Dnum<T>(logf(g.f), g.d / g.f); }
+template<class T> Dnum<T> Pow(Dnum<T> g, float n) {
+	return  Dnum<T>(powf(g.f, n), n * powf(g.f, n - 1) * g.d);
+}
+
+typedef Dnum<vec2> Dnum2;
+
+const int tessellationLevel = 50;
+const float eps = 0.001f;
+
+const int winWidth = 600, winHeight = 600;
+
+struct Camera
+{
+	vec3 wEye, wLookat, wVup; // external parameters
+	float fov, asp, fp, bp; // internal parameters
+public:
+	Camera(vec3 wEye, vec3 wLookat, vec3 wVup, float fovDeg = 40.0f, float bp = 20.0f)
+		: wEye(wEye), wLookat(wLookat), wVup(wVup), bp(bp)
+	{
+		asp = (float)winWidth / winHeight;
+		fov = fovDeg * (float)M_PI / 180.0f;
+		fp = 1;
+	}
+	// view transformation
+	mat4 V() { return lookAt(wEye, wLookat, wVup); }
+	// perspective transformation
+	mat4 P() { return perspective(fov, asp, fp, bp); }
+};
+
+struct Light {
+	vec3 La, Le;
+	vec4 wLightPos;
+};
+struct Material
+{
+	vec3 ka, kd, ks;
+	float shine;
+};
+
+struct VertexData
+{
+	vec3 position, normal;
+};
+
+// outputs of the vertex shader, interpolated for the fragment shader
+struct Varyings
+{
+	vec3 wNormal, wView, wLight;
+
+	Varyings operator+(const Varyings& v) const { return { wNormal + v.wNormal, wView + v.wView, wLight + v.wLight }; }
+	Varyings operator*(float s) const { return { wNormal * s, wView * s, wLight * s }; }
+};
+
+// C++ counterpart of a GPUProgram: the uniforms are members of the derived classes
+class SoftwareShader
+{
+public:
+	virtual vec4 Vertex(const VertexData& vtx, Varyings& out) const = 0;	// returns the clip space position
+	virtual vec3 Fragment(const Varyings& in) const = 0;
+	virtual SoftwareShader* Clone() const = 0;	// copy of the current uniform values
+	virtual ~SoftwareShader() {}
+};
+
+// Phong shader (per-pixel shading), same as vertSourcePhong/fragSourcePhong of ParamSurfaces
+class PhongShader : public SoftwareShader
+{
+public:
+	mat4 MVP, M, Minv; // MVP, Model, Model-inverse
+	vec4 wLiPos; // pos of light source
+	vec3 wEye; // pos of eye
+	vec3 kd, ks, ka; // diffuse, specular, ambient ref
+	float shine; // shininess for specular ref
+	vec3 La, Le; // ambient and dir/point source rad
+
+	vec4 Vertex(const VertexData& vtx, Varyings& out) const
+	{
+		vec4 wPos = M * vec4(vtx.position, 1);
+		out.wLight = vec3(wLiPos) * wPos.w - vec3(wPos) * wLiPos.w;
+		out.wView = wEye - vec3(wPos) / wPos.w;
+		out.wNormal = vec3(vec4(vtx.normal, 0) * Minv);
+		return MVP * vec4(vtx.position, 1);
+	}
+
+	vec3 Fragment(const Varyings& in) const
+	{
+		vec3 N = normalize(in.wNormal);
+		vec3 V = normalize(in.wView);
+		if (dot(N, V) < 0) N = -N;
+
+		vec3 L = normalize(in.wLight);
+		vec3 H = normalize(L + V);
+		float cost = max(dot(N, L), 0.0f), cosd = max(dot(N, H), 0.0f);
+		return ka * La + (kd * cost + ks * powf(cosd, shine)) * Le;
+	}
+
+	SoftwareShader* Clone() const { return new PhongShader(*this); }
+};
+
+// Vertex processing, clipping and triangle setup are done at draw time, the triangles are binned
+// into screen tiles and Flush() rasterizes the tiles in parallel with depth test and shading.
+class SoftwarePipeline : public HalfSpaceRasterizer
+{
+public:
+	static constexpr unsigned int RestartIndex = 0xFFFFFFFF; // same as Geometry::restartIndex
+
+private:
+	static constexpr float GuardBand = 16.0f;	// x and y are clipped at +-GuardBand * w only
+
+	struct ClipVertex
+	{
+		vec4 position;
+		Varyings varyings;
+	};
+
+	struct Triangle : Edges
+	{
+		float invArea2;				// E_k / (2 * area) is the barycentric weight of vertex k + 2
+		float z[3], invW[3];		// window depth and 1/w of the vertices
+		Varyings varyingsW[3];		// varyings / w
+		const SoftwareShader* shader;	// uniforms of the draw call
+	};
+
+	int nThreads;
+	std::vector<vec3> colorBuffer;
+	std::vector<float> depthBuffer;
+	std::vector<ClipVertex> transformed;
+	std::vector<Triangle> triangles;
+	std::vector<std::unique_ptr<const SoftwareShader>> draws; // uniforms of the draw calls since the last Flush()
+
+	// Sutherland-Hodgman clipping of a convex polygon against the planes dot(plane, position) >= 0
+	static void ClipPolygon(std::vector<ClipVertex>& polygon, std::vector<ClipVertex>& scratch)
+	{
+		static const vec4 planes[] = {
+			vec4(0, 0, 1, 1), vec4(0, 0, -1, 1),		// near, far
+			vec4(1, 0, 0, GuardBand), vec4(-1, 0, 0, GuardBand),
+			vec4(0, 1, 0, GuardBand), vec4(0, -1, 0, GuardBand)
+		};
+		for (const vec4& plane : planes)
+		{
+			scratch.clear();
+			for (size_t i = 0; i < polygon.size(); i++)
+			{
+				const ClipVertex& p = polygon[i];
+				const ClipVertex& q = polygon[(i + 1) % polygon.size()];
+				float dp = dot(plane, p.position), dq = dot(plane, q.position);
+				if (dp >= 0) scratch.push_back(p);
+				if ((dp >= 0) != (dq >= 0))
+				{
+					float t = dp / (dp - dq);
+					scratch.push_back({ mix(p.position, q.position, t), p.varyings * (1 - t) + q.varyings * t });
+				}
+			}
+			polygon.swap(scratch);
+			if (polygon.size() < 3) return;
+		}
+	}
+
+	static bool Inside(const vec4& p)
+	{
+		return p.z >= -p.w && p.z <= p.w && fabsf(p.x) <= GuardBand * p.w && fabsf(p.y) <= GuardBand * p.w;
+	}
+
+	void SetupTriangle(const ClipVertex* v[3], const SoftwareShader* shader)
+	{
+		Triangle tri;
+		int X[3], Y[3];
+		for (int k = 0; k < 3; k++)
+		{
+			float invW = 1.0f / v[k]->position.w;
+			vec3 ndc = vec3(v[k]->position) * invW;
+			X[k] = (int)lroundf((ndc.x + 1) * 0.5f * width * One);
+			Y[k] = (int)lroundf((1 - ndc.y) * 0.5f * height * One);
+			tri.z[k] = ndc.z * 0.5f + 0.5f;
+			tri.invW[k] = invW;
+			tri.varyingsW[k] = v[k]->varyings * invW;
+		}
+
+		long long area2 = Area2(X, Y);
+		if (area2 == 0) return;
+		if (area2 < 0)
+		{
+			std::swap(X[1], X[2]); std::swap(Y[1], Y[2]);
+			std::swap(tri.z[1], tri.z[2]); std::swap(tri.invW[1], tri.invW[2]);
+			std::swap(tri.varyingsW[1], tri.varyingsW[2]);
+			area2 = -area2;
+		}
+		tri.invArea2 = 1.0f / (float)area2;
+
+		if (!SetupEdges(X, Y, tri)) return;
+		tri.shader = shader;
+
+		triangles.push_back(tri);
+		Bin(tri, (int)triangles.size() - 1);
+	}
+
+	void ShadePixel(const Triangle& tri, int x, int y)
+	{
+		long long sx = (long long)x * One + One / 2, sy = (long long)y * One + One / 2;
+		float l[3];	// without the fill rule bias, otherwise the weights of tiny triangles do not sum to one
+		for (int k = 0; k < 3; k++)
+			l[(k + 2) % 3] = (float)(tri.A[k] * sx + tri.B[k] * sy + tri.C[k] + !TopLeft(tri.A[k], tri.B[k])) * tri.invArea2;
+
+		// depth is affine in screen space, the varyings only after dividing by w
+		float z = l[0] * tri.z[0] + l[1] * tri.z[1] + l[2] * tri.z[2];
+		float& depth = depthBuffer[y * width + x];
+		if (z >= depth) return;
+		depth = z;
+
+		float invW = l[0] * tri.invW[0] + l[1] * tri.invW[1] + l[2] * tri.invW[2];
+		Varyings varyings = (tri.varyingsW[0] * l[0] + tri.varyingsW[1] * l[1] + tri.varyingsW[2] * l[2]) * (1.0f / invW);
+		colorBuffer[y * width + x] = tri.shader->Fragment(varyings);
+	}
+
+	void ClipAndSetup(const ClipVertex* v[3], const SoftwareShader* shader, std::vector<ClipVertex>& polygon, std::vector<ClipVertex>& scratch)
+	{
+		if (Inside(v[0]->position) && Inside(v[1]->position) && Inside(v[2]->position))
+		{
+			SetupTriangle(v, shader);
+			return;
+		}
+
+		polygon.assign({ *v[0], *v[1], *v[2] });
+		ClipPolygon(polygon, scratch);
+		for (size_t k = 1; k + 1 < polygon.size(); k++)
+		{
+			const ClipVertex* fan[3] = { &polygon[0], &polygon[k], &polygon[k + 1] };
+			SetupTriangle(fan, shader);
+		}
+	}
+
+public:
+	SoftwarePipeline(int _width, int _height, int _nThreads = (int)std::thread::hardware_concurrency())
+		: HalfSpaceRasterizer(_width, _height), nThreads(max(1, _nThreads)), colorBuffer(_width * _height), depthBuffer(_width * _height) { }
+
+	const std::vector<vec3>& ColorBuffer() const { return colorBuffer; }
+
+	void Clear(vec3 color)
+	{
+		std::fill(colorBuffer.begin(), colorBuffer.end(), color);
+		std::fill(depthBuffer.begin(), depthBuffer.end(), 1.0f);
+	}
+
+	// same as glDrawElements(GL_TRIANGLE_STRIP, ...) with primitive restart at RestartIndex;
+	// the uniforms of the shader are copied like a GL draw call does, so the shader can be
+	// set up for the next draw before Flush()
+	void DrawTriangleStrips(const std::vector<VertexData>& vtx, const std::vector<unsigned int>& idx, const SoftwareShader& shader)
+	{
+		draws.emplace_back(shader.Clone());
+		const SoftwareShader* uniforms = draws.back().get();
+
+		transformed.resize(vtx.size());
+		const int chunk = 1024;
+		ParallelFor(nThreads, (int)(vtx.size() + chunk - 1) / chunk, [&](int c) {
+			size_t end = min(vtx.size(), (size_t)(c + 1) * chunk);
+			for (size_t i = (size_t)c * chunk; i < end; i++)
+				transformed[i].position = uniforms->Vertex(vtx[i], transformed[i].varyings);
+		});
+
+		std::vector<ClipVertex> polygon, scratch;
+		size_t stripStart = 0;
+		for (size_t i = 0; i < idx.size(); i++)
+		{
+			if (idx[i] == RestartIndex)
+			{
+				stripStart = i + 1;
+				continue;
+			}
+			if (i < stripStart + 2) continue;
+			const ClipVertex* v[3] = { &transformed[idx[i - 2]], &transformed[idx[i - 1]], &transformed[idx[i]] };
+			ClipAndSetup(v, uniforms, polygon, scratch);
+		}
+	}
+
+	// rasterize the binned triangles, one tile at a time per thread
+	void Flush()
+	{
+		FlushTiles(nThreads, [&](int index, int minX, int minY, int maxX, int maxY) {
+			const Triangle& tri = triangles[index];
+			Rasterize(tri, minX, minY, maxX, maxY, [&](int x, int y) { ShadePixel(tri, x, y); });
+		});
+		triangles.clear();
+		draws.clear();
+	}
+
+	bool SavePNG(const std::string& fileName) const
+	{
+		std::vector<unsigned char> rgb(3 * colorBuffer.size());
+		for (size_t i = 0; i < colorBuffer.size(); i++)
+			for (int c = 0; c < 3; c++)
+				rgb[3 * i + c] = (unsigned char)(clamp(colorBuffer[i][c], 0.0f, 1.0f) * 255.0f + 0.5f);
+		unsigned error = lodepng_encode24_file(fileName.c_str(), rgb.data(), width, height);
+		if (error) printf("Error while writing %s: %s\n", fileName.c_str(), lodepng_error_text(error));
+		return error == 0;
+	}
+};
+
+//---------------------------
+class ParamSurface {
+
+	std::vector<VertexData> vtx;
+	std::vector<unsigned int> idx;
+
+public:
+	float rotAngle;
+	vec3 translation, rotAxis, scaling;
+
+	Material material;
+
+	ParamSurface(vec3 position, Material material)
+		: rotAngle(0.0f), translation(position), rotAxis(1.0f), scaling(1.0f), material(material) { }
+	virtual ~ParamSurface() {}
+
+	virtual void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z) = 0;
+
+	virtual VertexData GenVertexData(float u, float v) {
+		VertexData vtxData;
+		Dnum2 X, Y, Z;
+		Dnum2 U(u, vec2(1, 0)), V(v, vec2(0, 1));
+		eval(U, V, X, Y, Z);
+		vtxData.position = vec3(X.f, Y.f, Z.f);
+		vec3 drdU(X.d.x, Y.d.x, Z.d.x), drdV(X.d.y, Y.d.y, Z.d.y);
+		vtxData.normal = cross(drdU, drdV);
+		return vtxData;
+	}
+
+	// every grid vertex once, the strips index them (as Geometry::GridStrips)
+	void create(int N = tessellationLevel, int M = tessellationLevel) {
+		vtx.clear();
+		for (int i = 0; i <= N; i++) {
+			for (int j = 0; j <= M; j++) {
+				vtx.push_back(GenVertexData((float)j / M, (float)i / N));
+			}
+		}
+		idx.clear();
+		for (int i = 0; i < N; i++) {
+			if (i > 0) idx.push_back(SoftwarePipeline::RestartIndex);
+			for (int j = 0; j <= M; j++) {
+				idx.push_back(i * (M + 1) + j);
+				idx.push_back((i + 1) * (M + 1) + j);
+			}
+		}
+	}
+
+	// pose at the given fraction of the animation loop
+	virtual void Animate(float turn) { rotAngle = 2.0f * (float)M_PI * turn; }
+
+	void Draw(Camera* camera, PhongShader* shader, SoftwarePipeline* pipeline)
+	{
+		// transformation matrices
+		shader->M = translate(translation) * rotate(rotAngle, rotAxis) * scale(scaling);
+		shader->Minv = scale(1.0f / scaling) * rotate(-rotAngle, rotAxis) * translate(-translation);
+		shader->MVP = camera->P() * camera->V() * shader->M;
+
+		// material properties
+		shader->kd = material.kd;
+		shader->ks = material.ks;
+		shader->ka = material.ka;
+		shader->shine = material.shine;
+
+		pipeline->DrawTriangleStrips(vtx, idx, *shader);
+	}
+};
+
+class PlaneXZ : public ParamSurface
+{
+public:
+	PlaneXZ(Material material) : ParamSurface(vec3(0.0f), material) { create(); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		X = U * 2.0f - 1.0f; Z = V * 2.0f - 1.0f; Y = 0.0f;
+	}
+};
+class Sphere : public ParamSurface
+{
+public:
+	Sphere(Material material) : ParamSurface(vec3(0.0f), material) { create(); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		U = U * 2.0f * (float)M_PI, V = V * (float)M_PI;
+		X = Cos(U) * Sin(V); Y = Sin(U) * Sin(V); Z = Cos(V);
+	}
+};
+class Cylinder : public ParamSurface
+{
+public:
+	Cylinder(Material material) : ParamSurface(vec3(0.0f), material) { create(); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		U = U * 2.0f * M_PI;
+		X = Cos(U); Z = Sin(U); Y = V * 2.0f - 1.0f;
+	}
+};
+class Cone : public ParamSurface
+{
+	float alpha;
+public:
+	Cone(float alpha, Material material) : ParamSurface(vec3(0.0f), material), alpha(alpha) { create(); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		U = U * 2.0f * M_PI;
+		X = V * tanf(alpha * 0.5f) * Cos(U); Z = V * tanf(alpha * 0.5f) * Sin(U); Y = V * -1.0f + 0.5f;
+	}
+};
+class Hyperboloid : public ParamSurface
+{
+public:
+	Hyperboloid(Material material) : ParamSurface(vec3(0.0f), material) { create(); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		U = U * 2.0f - 1.0f; V = V * 2.0f * M_PI;
+		X = Cosh(U) * Cos(V); Z = Cosh(U) * Sin(V); Y = Sinh(U);
+	}
+};
+class Torus : public ParamSurface
+{
+	float R, r;
+public:
+	Torus(float R, float r, Material material) : ParamSurface(vec3(0.0f), material), R(R), r(r) { create(); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		U = U * 2.0f * M_PI; V = V * 2.0f * M_PI;
+		X = (Cos(U) * r + R) * Cos(V); Z = (Cos(U) * r + R) * Sin(V); Y = Sin(U) * r;
+	}
+};
+
+// surfaces of 3Dmotorka
+class Tractricoid : public ParamSurface
+{
+public:
+	Tractricoid(Material material) : ParamSurface(vec3(0.0f), material) { create(100, 100); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		const float height = 3.0f;
+		U = U * height, V = V * 2 * M_PI;
+		X = Cos(V) / Cosh(U); Y = Sin(V) / Cosh(U); Z = U - Tanh(U);
+	}
+};
+class Mobius : public ParamSurface
+{
+public:
+	Mobius(Material material) : ParamSurface(vec3(0.0f), material) { create(100, 100); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		const float R = 1, width = 0.5f;
+		U = U * M_PI, V = (V - 0.5f) * width;
+		X = (Cos(U) * V + R) * Cos(U * 2);
+		Y = (Cos(U) * V + R) * Sin(U * 2);
+		Z = Sin(U) * V;
+	}
+};
+class Klein : public ParamSurface
+{
+public:
+	Klein(Material material) : ParamSurface(vec3(0.0f), material) { create(100, 100); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		U = U * M_PI * 2, V = V * M_PI * 2;
+		Dnum2 a = Cos(U) * (Sin(U) + 1) * 0.3f;
+		Dnum2 b = Sin(U) * 0.8f;
+		Dnum2 c = (Cos(U) * (-0.1f) + 0.2f);
+		X = a + c * ((U.f > M_PI) ? Cos(V + M_PI) : Cos(U) * Cos(V));
+		Y = b + ((U.f > M_PI) ? 0 : c * Sin(U) * Cos(V));
+		Z = c * Sin(V);
+	}
+};
+class Boy : public ParamSurface
+{
+public:
+	Boy(Material material) : ParamSurface(vec3(0.0f), material) { create(100, 100); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		U = (U - 0.5f) * M_PI, V = V * M_PI;
+		float r2 = sqrt(2.0f);
+		Dnum2 denom = (Sin(U * 3) * Sin(V * 2) * (-3 / r2) + 3) * 1.2f;
+		Dnum2 CosV2 = Cos(V) * Cos(V);
+		X = (Cos(U * 2) * CosV2 * r2 + Cos(U) * Sin(V * 2)) / denom;
+		Y = (Sin(U * 2) * CosV2 * r2 - Sin(U) * Sin(V * 2)) / denom;
+		Z = (CosV2 * 3) / denom;
+	}
+};
+class Dini : public ParamSurface
+{
+	Dnum2 a = 1.0f, b = 0.15f;
+public:
+	Dini(Material material) : ParamSurface(vec3(0.0f), material) { create(100, 100); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		U = U * 4 * M_PI, V = V * (1 - 0.1f) + 0.1f;
+		X = a * Cos(U) * Sin(V);
+		Y = a * Sin(U) * Sin(V);
+		Z = a * (Cos(V) + Log(Tan(V / 2))) + b * U + 3;
+	}
+};
+
+// the waving flag of Flag3D, its normal is parallel to the analytic one of the demo
+class Flag : public ParamSurface
+{
+public:
+	float W, H, D, K, phase;
+
+	Flag(float w, float h, float d, float k, float phase, Material material)
+		: ParamSurface(vec3(-w * 0.5f, -h * 0.5f, 0.0f), material), W(w), H(h), D(d), K(k), phase(phase) { create(20, 20); }
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		X = U * W; Y = V * H; Z = Sin(U * K + phase) * D;
+	}
+
+	// the flag waves instead of turning
+	void Animate(float turn)
+	{
+		phase = 2.0f * (float)M_PI * turn;
+		create(20, 20);
+	}
+};
+
+// gradient noise of PerlinNoise3D
+class PerlinNoise3D
+{
+	int gridSize;
+	std::vector<vec3> gradients;
+
+public:
+	PerlinNoise3D(int gridSize)
+		: gridSize(gridSize)
+	{
+		int gradDim = gridSize + 1;
+		gradients.resize(gradDim * gradDim * gradDim);
+		for (int z = 0; z < gradDim; z++)
+			for (int y = 0; y < gradDim; y++)
+				for (int x = 0; x < gradDim; x++)
+					gradients[(z * gradDim + y) * gradDim + x] = RandomUnitVector3D();
+	}
+	float Get(float x, float y, float z)
+	{
+		int x0 = x / gridSize, y0 = y / gridSize, z0 = z / gridSize; // top left corner of the grid cell
+		float dx = x / (float)gridSize - x0, dy = y / (float)gridSize - y0, dz = z / (float)gridSize - z0; // offset in the grid cell
+
+		// calculate u, v and w for the interpolation
+		float u = Fade(dx), v = Fade(dy), w = Fade(dz);
+
+		// helper function to retrieve gradients
+		auto gradient = [&](int i, int j, int k) -> vec3& {
+			int gradDim = gridSize + 1;
+			return gradients[((k % gradDim) * gradDim + (j % gradDim)) * gradDim + (i % gradDim)];
+		};
+
+		// dot products with the gradients in the corners of the grid cell
+		float dot000 = dot(gradient(x0, y0, z0), vec3(dx, dy, dz));
+		float dot100 = dot(gradient(x0 + 1, y0, z0), vec3(dx - 1, dy, dz));
+		float dot010 = dot(gradient(x0, y0 + 1, z0), vec3(dx, dy - 1, dz));
+		float dot110 = dot(gradient(x0 + 1, y0 + 1, z0), vec3(dx - 1, dy - 1, dz));
+
+		float dot001 = dot(gradient(x0, y0, z0 + 1), vec3(dx, dy, dz - 1));
+		float dot101 = dot(gradient(x0 + 1, y0, z0 + 1), vec3(dx - 1, dy, dz - 1));
+		float dot011 = dot(gradient(x0, y0 + 1, z0 + 1), vec3(dx, dy - 1, dz - 1));
+		float dot111 = dot(gradient(x0 + 1, y0 + 1, z0 + 1), vec3(dx - 1, dy - 1, dz - 1));
+
+		// interpolate between the dot products based on u, v and w
+		float y0i = Lerp(Lerp(dot000, dot100, u), Lerp(dot010, dot110, u), v);
+		float y1i = Lerp(Lerp(dot001, dot101, u), Lerp(dot011, dot111, u), v);
+		return Lerp(y0i, y1i, w);
+	}
+
+private:
+	vec3 RandomUnitVector3D()
+	{
+		float theta = RandFloat() * 2 * M_PI;
+		float phi = acosf(2 * RandFloat() - 1);
+		return vec3(
+			sin(phi) * cos(theta),
+			sin(phi) * sin(theta),
+			cos(phi)
+		);
+	}
+	float RandFloat() { return rand() / (float)RAND_MAX; }
+	float Fade(float t) { return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); }
+	float Lerp(float a, float b, float t) { return a + (b - a) * t; }
+};
+
+// height map terrain of PerlinNoise3D, generated once at t = 0
+class Terrain : public ParamSurface
+{
+	int w, h;
+	std::vector<float> heightMap;
+
+	vec3 evalPoint(float u, float v)
+	{
+		int x = u * (w - 1);
+		int y = v * (h - 1);
+		return { u * 2.0f - 1.0f, heightMap[y * w + x] * 0.2f, v * 2.0f - 1.0f };
+	}
+
+public:
+	Terrain(int w, int h, Material material) : ParamSurface(vec3(0.0f), material), w(w), h(h), heightMap(w * h)
+	{
+		PerlinNoise3D perlin(80);
+		float minValue = 1.0f, maxValue = -1.0f;
+		for (int y = 0; y < h; y++)
+		{
+			for (int x = 0; x < w; x++)
+			{
+				float value = perlin.Get(x, y, 0.0f);
+				minValue = min(minValue, value);
+				maxValue = max(maxValue, value);
+				heightMap[y * w + x] = value;
+			}
+		}
+		for (float& value : heightMap)
+			value = (value - minValue) / (maxValue - minValue);
+		create();
+	}
+
+	void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z)
+	{
+		vec3 p = evalPoint(U.f, V.f);
+		X = p.x; Y = p.y; Z = p.z;
+	}
+
+	// the samples of the height map are constant, so the normal comes from central differences
+	VertexData GenVertexData(float u, float v)
+	{
+		vec3 du = evalPoint(u + eps, v) - evalPoint(u - eps, v);
+		vec3 dv = evalPoint(u, v + eps) - evalPoint(u, v - eps);
+		return { evalPoint(u, v), normalize(cross(du, dv)) };
+	}
+};
+
+// the surfaces of a scene are drawn with their own materials before a single Flush()
+struct Scene
+{
+	std::string name;
+	Camera camera;
+	Light light;
+	vec3 background;
+	std::vector<ParamSurface*> surfaces;
+
+	~Scene() { for (ParamSurface* surface : surfaces) delete surface; }
+
+	void Render(float turn, PhongShader* shader, SoftwarePipeline* pipeline)
+	{
+		shader->La = light.La;
+		shader->Le = light.Le;
+		shader->wLiPos = light.wLightPos;
+		shader->wEye = camera.wEye;
+
+		pipeline->Clear(background);
+		for (ParamSurface* surface : surfaces)
+		{
+			surface->Animate(turn);
+			surface->Draw(&camera, shader, pipeline);
+		}
+		pipeline->Flush();
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	std::string outDir = ".";
+	int nFrames = 60;
+	int nThreads = (int)std::thread::hardware_concurrency();
+
+	for (int a = 1; a < argc; a++)
+	{
+		bool hasValue = a + 1 < argc;
+		if (!strcmp(argv[a], "-o") && hasValue) outDir = argv[++a];
+		else if (!strcmp(argv[a], "-n") && hasValue) nFrames = max(1, atoi(argv[++a]));
+		else if (!strcmp(argv[a], "-t") && hasValue) nThreads = atoi(argv[++a]);
+		else
+		{
+			printf("Usage: %s [-o dir] [-n frames] [-t threads]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::vector<Scene*> scenes;
+
+	// ParamSurfaces: one surface at a time
+	Material material{ vec3(0.15f, 0.6f, 0.9f), vec3(0.05f, 0.2f, 0.3f), vec3(0.6f, 0.6f, 0.6f), 20.0f };
+	Light light{ vec3(0.4f), vec3(1.0f), vec4(1.0f, 1.0f, 1.0f, 0.0f) };
+	Camera camera(vec3(0.0f, 1.0f, 5.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+
+	ParamSurface* surfaces[6];
+	surfaces[0] = new PlaneXZ(material); surfaces[0]->translation = vec3(0.0f, -1.0f, 0.0f);
+	surfaces[1] = new Sphere(material);
+	surfaces[2] = new Cylinder(material); surfaces[2]->translation = vec3(0.0f, -0.8f, 0.0f); surfaces[2]->scaling = vec3(0.4f, 0.8f, 0.4f);
+	surfaces[3] = new Cone(0.5f, material); surfaces[3]->scaling = vec3(2.0f);
+	surfaces[4] = new Hyperboloid(material); surfaces[4]->scaling = vec3(0.6f);
+	surfaces[5] = new Torus(1.0f, 0.25f, material); surfaces[5]->translation = vec3(0.0f, -0.8f, 0.0f);
+	for (int s = 0; s < 6; s++)
+	{
+		surfaces[s]->rotAxis = vec3(0.0f, 1.0f, 0.0f);
+		scenes.push_back(new Scene{ "surface_" + std::to_string(s), camera, light, vec3(0.0f), { surfaces[s] } });
+	}
+
+	// 3Dmotorka: the Phong row of objects, each with its own color
+	Scene* motorka = new Scene{ "motorka", Camera(vec3(0.0f, 5.0f, 27.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f), 45.0f, 40.0f),
+		Light{ vec3(0.0f), vec3(1.0f), vec4(5.0f, 5.0f, 4.0f, 0.0f) }, vec3(0.3f, 0.3f, 1.0f), { } };
+	auto motorkaMaterial = [](vec3 color) { return Material{ color * 0.5f, color, vec3(0.0f), 100.0f }; };
+	ParamSurface* cylinder = new Cylinder(motorkaMaterial(vec3(1.0f, 1.0f, 0.0f)));
+	cylinder->scaling = vec3(0.5f, 1.0f, 0.5f); cylinder->rotAxis = vec3(0.0f, 0.0f, 1.0f);
+	ParamSurface* tractricoid = new Tractricoid(motorkaMaterial(vec3(1.0f, 0.5f, 0.0f)));
+	tractricoid->rotAxis = vec3(1.0f, 0.0f, 0.0f);
+	ParamSurface* torus = new Torus(1.0f, 0.5f, motorkaMaterial(vec3(1.0f, 0.2f, 0.2f)));
+	torus->scaling = vec3(0.7f); torus->rotAxis = vec3(1.0f, 0.0f, 0.0f);
+	ParamSurface* mobius = new Mobius(motorkaMaterial(vec3(1.0f, 0.3f, 1.0f)));
+	mobius->scaling = vec3(0.7f); mobius->rotAxis = vec3(1.0f, 0.0f, 0.0f);
+	ParamSurface* klein = new Klein(motorkaMaterial(vec3(0.3f, 1.0f, 1.0f)));
+	klein->rotAxis = vec3(0.0f, 0.0f, 1.0f);
+	ParamSurface* boy = new Boy(motorkaMaterial(vec3(0.3f, 1.0f, 0.3f)));
+	boy->rotAxis = vec3(0.0f, 0.0f, 1.0f);
+	ParamSurface* dini = new Dini(motorkaMaterial(vec3(1.0f, 1.0f, 1.0f)));
+	dini->scaling = vec3(0.7f); dini->rotAxis = vec3(1.0f, 0.0f, 0.0f);
+	motorka->surfaces = { cylinder, tractricoid, torus, mobius, klein, boy, dini };
+	for (size_t s = 0; s < motorka->surfaces.size(); s++)
+		motorka->surfaces[s]->translation = vec3(-9.0f + 3.0f * s, 3.0f, 0.0f);
+	scenes.push_back(motorka);
+
+	// Flag3D
+	Material flagMaterial{ vec3(0.15f, 0.6f, 0.9f), vec3(0.05f, 0.2f, 0.3f), vec3(0.6f, 0.6f, 0.6f), 50.0f };
+	scenes.push_back(new Scene{ "flag", Camera(vec3(0.0f, 0.0f, 5.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f)),
+		Light{ vec3(0.4f), vec3(2.0f), vec4(1.0f, 1.0f, 1.0f, 0.0f) }, vec3(0.0f), { new Flag(2.0f, 1.5f, 0.5f, 3.0f, 0.0f, flagMaterial) } });
+
+	// PerlinNoise3D
+	Material terrainMaterial{ vec3(0.15f, 0.6f, 0.9f), vec3(0.05f, 0.2f, 0.3f), vec3(0.8f), 60.0f };
+	ParamSurface* terrain = new Terrain(winWidth, winHeight, terrainMaterial);
+	terrain->rotAxis = vec3(0.0f, 1.0f, 0.0f);
+	scenes.push_back(new Scene{ "terrain", Camera(vec3(0.0f, 2.0f, 3.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f)), light, vec3(0.0f), { terrain } });
+
+	PhongShader shader;
+	SoftwarePipeline pipeline(winWidth, winHeight, nThreads);
+	bool ok = true;
+	for (Scene* scene : scenes)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < nFrames; frame++)
+			scene->Render((float)frame / nFrames, &shader, &pipeline);
+		auto end = std::chrono::high_resolution_clock::now();
+		printf("%s: %.3f ms/frame\n", scene->name.c_str(), std::chrono::duration<float, std::milli>(end - start).count() / nFrames);
+
+		scene->Render(0.0f, &shader, &pipeline);
+		ok = pipeline.SavePNG(outDir + "/" + scene->name + ".png") && ok;
+	}
+
+	for (Scene* scene : scenes) delete scene;
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -30,30 +30,112 @@ const char* fragSource = R"(
 	}
 )";
 
+// curve vertex shader: the spline from the control points in a texture buffer, gl_VertexID is the sample
+const char* curveVertSource = R"(
+	#version 330
+    precision highp float;
+
+	uniform samplerBuffer controlPoints;	// xy
+	uniform int nControlPoints, nSamples;
+
+	vec2 P(int i) { return texelFetch(controlPoints, clamp(i, 0, nControlPoints - 1)).xy; }
+
+	void main()
+	{
+		// uniform knots, as on the CPU
+		float tau = float(gl_VertexID) / float(nSamples - 1);
+		int nSegments = nControlPoints - 1;
+		int i = min(int(tau * float(nSegments)), nSegments - 1);
+		float dt = 1.0 / float(nSegments), t = tau - float(i) * dt;
+
+		vec2 p0 = P(i), p1 = P(i + 1);
+		vec2 v0 = i > 0 ? (p1 - P(i - 1)) / (2.0 * dt) : vec2(0, 0);
+		vec2 v1 = i < nSegments - 1 ? (P(i + 2) - p0) / (2.0 * dt) : vec2(0, 0);
+		vec2 a2 = 3.0 * (p1 - p0) / dt / dt - (v1 + 2.0 * v0) / dt;
+		vec2 a3 = 2.0 * (p0 - p1) / dt / dt / dt + (v1 + v0) / dt / dt;
+		gl_Position = vec4(((a3 * t + a2) * t + v0) * t + p0, 0, 1);
+	}
+)";
+
 const int winWidth = 600, winHeight = 600;
 
 const int nTessVertices = 500;
+
+// adaptive: screen space adaptive tessellation, uniform: nTessVertices + 1 samples on the CPU,
+// gpu: only the control points are uploaded, the vertex shader evaluates the samples
+enum Tessellation { TESSELLATION_ADAPTIVE, TESSELLATION_UNIFORM, TESSELLATION_GPU };
+const char* tessellationNames[] = { "adaptive", "uniform", "GPU" };
+
 class Spline
 {
 	Geometry<vec2>* controlPoints;
 	std::vector<float> knotValues;
 	Geometry<vec2>* curvePoints;
 
+	// Hermite polynomial of a segment in (t - t0), with the range of the curve samples it makes
+	struct Segment
+	{
+		vec2 a0, a1, a2, a3;
+		float t0;
+		int firstSample, endSample;
+		std::vector<vec2> vertices;	// adaptive: its own tessellation from t_i to t_i+1
+	};
+	std::vector<Segment> segments;
+
 	vec2* selectedPoint = nullptr;
+	Tessellation tessellation = TESSELLATION_ADAPTIVE;
+	CurveTessellator tessellator = CurveTessellator(0.25f, 512); // per segment
+
+	TextureBuffer* gpuControlPoints;
+	std::vector<vec4> gpuData;
+	unsigned int emptyVao;	// the GPU samples have no attributes
+	int nGpuSamples = nTessVertices + 1;
 
 public:
-	Spline() { controlPoints = new Geometry<vec2>(); curvePoints = new Geometry<vec2>(); }
-	~Spline() { delete controlPoints; delete curvePoints; }
+	Spline()
+	{
+		controlPoints = new Geometry<vec2>(); curvePoints = new Geometry<vec2>();
+		gpuControlPoints = new TextureBuffer();
+		glGenVertexArrays(1, &emptyVao);
+	}
+	~Spline() { delete controlPoints; delete curvePoints; delete gpuControlPoints; glDeleteVertexArrays(1, &emptyVao); }
 
 	void AddControlPoint(vec2 cp)
 	{
 		controlPoints->Vtx().push_back(cp);
 		controlPoints->updateGPU();
 		Recalculate();
+		if (tessellation == TESSELLATION_ADAPTIVE)
+			printf("%d curve vertices\n", (int)curvePoints->Vtx().size());
+	}
+	Tessellation GetTessellation() const { return tessellation; }
+	int SetTessellation(Tessellation _tessellation) // returns the new vertex count
+	{
+		tessellation = _tessellation;
+		Recalculate();
+		return tessellation == TESSELLATION_GPU ? nGpuSamples : (int)curvePoints->Vtx().size();
+	}
+	// GPU samples, no CPU work
+	int ScaleGpuSamples(float factor)
+	{
+		nGpuSamples = clamp((int)(nGpuSamples * factor), 2, 1 << 20);
+		return nGpuSamples;
 	}
-	void Render(GPUProgram* gpuProgram)
+	void Render(GPUProgram* gpuProgram, GPUProgram* curveProgram)
 	{
-		if (controlPoints->Vtx().size() >= 2)
+		if (controlPoints->Vtx().size() >= 2 && tessellation == TESSELLATION_GPU)
+		{
+			curveProgram->Use();
+			gpuControlPoints->Bind(0);
+			curveProgram->setUniform(0, "controlPoints");
+			curveProgram->setUniform((int)controlPoints->Vtx().size(), "nControlPoints");
+			curveProgram->setUniform(nGpuSamples, "nSamples");
+			curveProgram->setUniform(vec3(1.0f, 1.0f, 0.0f), "color");
+			glBindVertexArray(emptyVao);
+			glDrawArrays(GL_LINE_STRIP, 0, nGpuSamples);
+			gpuProgram->Use();
+		}
+		else if (controlPoints->Vtx().size() >= 2)
 			curvePoints->Draw(gpuProgram, GL_LINE_STRIP, { 1.0f, 1.0f, 0.0f });
 		
 		if (controlPoints->Vtx().size() == 0)
@@ -90,9 +172,27 @@ public:
 	{
 		if (selectedPoint)
 		{
+			// a point is in the Hermite data of at most two segments on each side
+			int k = (int)(selectedPoint - &controlPoints->Vtx()[0]);
 			*selectedPoint = p;
-			controlPoints->updateGPU();
-			Recalculate();
+			controlPoints->updateGPU(k, 1);
+			if (tessellation == TESSELLATION_GPU)
+				UploadControlPoints();
+			else if (segments.size() > 0)
+			{
+				int first = max(k - 2, 0), last = min(k + 1, (int)segments.size() - 1);
+				for (int i = first; i <= last; i++) UpdateSegment(i);
+				if (tessellation == TESSELLATION_ADAPTIVE) // the vertex counts change, everything moves
+				{
+					JoinSegments();
+					curvePoints->updateGPU();
+				}
+				else
+				{
+					int begin = segments[first].firstSample, end = segments[last].endSample;
+					curvePoints->updateGPU(begin, end - begin);
+				}
+			}
 			return true;
 		}
 		return false;
@@ -101,80 +201,110 @@ public:
 private:
 	void Recalculate()
 	{
-		knotValues.push_back(69);
+		knotValues.resize(controlPoints->Vtx().size());
 		for (int i = 0; i < controlPoints->Vtx().size(); i++)
 			knotValues[i] = (float)i / (controlPoints->Vtx().size() - 1);
 
-		curvePoints->Vtx() = GenerateVertices();
+		if (tessellation == TESSELLATION_GPU)
+		{
+			UploadControlPoints();
+			return;
+		}
+		GenerateVertices();
 		if (curvePoints->Vtx().size() >= 2)
 			curvePoints->updateGPU();
 	}
 
-	std::vector<vec2> GenerateVertices()
+	// a few bytes per control point
+	void UploadControlPoints()
 	{
-		if (controlPoints->Vtx().size() < 2)
-			return {};
-
-		std::vector<vec2> vertices;
-		for (int i = 0; i <= nTessVertices; ++i)
-		{
-			float t = (float)i / nTessVertices;
-			vertices.push_back(r(t));
-		}
-		return vertices;
+		gpuData.resize(controlPoints->Vtx().size());
+		for (int i = 0; i < gpuData.size(); i++) gpuData[i] = vec4(controlPoints->Vtx()[i], 0, 0);
+		gpuControlPoints->updateGPU(gpuData);
 	}
-	vec2 r(float tau)
+
+	// every segment makes the samples t = s / nTessVertices in [t_i, t_i+1), the last one t = 1 too
+	void GenerateVertices()
 	{
 		const auto& cps = controlPoints->Vtx();
-		for (int i = 0; i < cps.size() - 1; i++)
+		if (cps.size() < 2)
 		{
-			if (knotValues[i] <= tau && tau <= knotValues[i + 1])
-			{
-				vec2 v0(0, 0), v1(0, 0);
-				if (i > 0)
-					v0 = (cps[i + 1] - cps[i - 1]) / (knotValues[i + 1] - knotValues[i - 1]);
-				if (i < cps.size() - 2)
-					v1 = (cps[i + 2] - cps[i]) / (knotValues[i + 2] - knotValues[i]);
-
-				return Hermite(
-					cps[i],
-					v0,
-					knotValues[i],
-
-					cps[i + 1],
-					v1,
-					knotValues[i + 1],
-
-					tau
-				);
-			}
+			segments.clear();
+			curvePoints->Vtx().clear();
+			return;
+		}
+
+		int nSegments = (int)cps.size() - 1;
+		segments.resize(nSegments);
+		curvePoints->Vtx().resize(nTessVertices + 1);
+		for (int i = 0; i < nSegments; i++)
+		{
+			segments[i].firstSample = (i * nTessVertices + nSegments - 1) / nSegments; // ceil
+			segments[i].endSample = i < nSegments - 1 ? ((i + 1) * nTessVertices + nSegments - 1) / nSegments : nTessVertices + 1;
 		}
+		for (int i = 0; i < nSegments; i++) UpdateSegment(i);
+		if (tessellation == TESSELLATION_ADAPTIVE)
+			JoinSegments();
 	}
-	vec2 Hermite(const vec2& p0, const vec2& v0, float t0, const vec2& p1, const vec2& v1, float t1, float t)
+
+	// the adaptive tessellations of the segments one after the other, the common end points once
+	void JoinSegments()
+	{
+		auto& vertices = curvePoints->Vtx();
+		vertices.clear();
+		for (int i = 0; i < segments.size(); i++)
+			vertices.insert(vertices.end(), segments[i].vertices.begin() + (i > 0 ? 1 : 0), segments[i].vertices.end());
+	}
+
+	// the Hermite coefficients from the control points, then the samples of the segment
+	void UpdateSegment(int i)
 	{
-		t -= t0;
-		float dt = t1 - t0;
-		vec2 a0 = p0, a1 = v0;
-		vec2 a2 = 3.0f * (p1 - p0) / dt / dt - (v1 + 2.0f * v0) / dt;
-		vec2 a3 = 2.0f * (p0 - p1) / dt / dt / dt + (v1 + v0) / dt / dt;
+		const auto& cps = controlPoints->Vtx();
+		vec2 v0(0, 0), v1(0, 0);
+		if (i > 0)
+			v0 = (cps[i + 1] - cps[i - 1]) / (knotValues[i + 1] - knotValues[i - 1]);
+		if (i < cps.size() - 2)
+			v1 = (cps[i + 2] - cps[i]) / (knotValues[i + 2] - knotValues[i]);
+
+		Segment& seg = segments[i];
+		vec2 p0 = cps[i], p1 = cps[i + 1];
+		float dt = knotValues[i + 1] - knotValues[i];
+		seg.a0 = p0;
+		seg.a1 = v0;
+		seg.a2 = 3.0f * (p1 - p0) / dt / dt - (v1 + 2.0f * v0) / dt;
+		seg.a3 = 2.0f * (p0 - p1) / dt / dt / dt + (v1 + v0) / dt / dt;
+		seg.t0 = knotValues[i];
 
-		return ((a3 * t + a2) * t + a1) * t + a0;
+		if (tessellation == TESSELLATION_ADAPTIVE)
+		{
+			tessellator.Tessellate([&seg](float t) { t -= seg.t0; return ((seg.a3 * t + seg.a2) * t + seg.a1) * t + seg.a0; },
+				knotValues[i], knotValues[i + 1], scale(vec3(winWidth / 2.0f, winHeight / 2.0f, 1.0f)), seg.vertices, 4);
+			return;
+		}
+		auto& vertices = curvePoints->Vtx();
+		for (int s = seg.firstSample; s < seg.endSample; s++)
+		{
+			float t = (float)s / nTessVertices - seg.t0;
+			vertices[s] = ((seg.a3 * t + seg.a2) * t + seg.a1) * t + seg.a0;
+		}
 	}
 };
 
 class CatmullRomApp : public glApp {
 	Spline* spline;
 	GPUProgram* gpuProgram;
+	GPUProgram* curveProgram;
 
 public:
 	CatmullRomApp() : glApp("Catmull-Rom Spline") {}
-	~CatmullRomApp() { delete gpuProgram; delete spline; }
+	~CatmullRomApp() { delete gpuProgram; delete curveProgram; delete spline; }
 
 	void onInitialization() override
 	{
 		glPointSize(10);
 		glLineWidth(3);
 
+		curveProgram = new GPUProgram(curveVertSource, fragSource);
 		gpuProgram = new GPUProgram(vertSource, fragSource);
 		spline = new Spline;
 	}
@@ -185,7 +315,23 @@ public:
 		glClear(GL_COLOR_BUFFER_BIT);
 		glViewport(0, 0, winWidth, winHeight);
 
-		spline->Render(gpuProgram);
+		spline->Render(gpuProgram, curveProgram);
+	}
+
+	// t: next tessellation, +/-: GPU sample count
+	void onKeyboard(int key) override
+	{
+		if (key == 't')
+		{
+			int nVertices = spline->SetTessellation((Tessellation)((spline->GetTessellation() + 1) % 3));
+			printf("%s tessellation: %d curve vertices\n", tessellationNames[spline->GetTessellation()], nVertices);
+			refreshScreen();
+		}
+		if ((key == '+' || key == '-') && spline->GetTessellation() == TESSELLATION_GPU)
+		{
+			printf("%d GPU samples\n", spline->ScaleGpuSamples(key == '+' ? 2.0f : 0.5f));
+			refreshScreen();
+		}
 	}
 
 	void onMousePressed(MouseButton but, int pX, int pY) override
@@ -33,6 +33,7 @@ const int winWidth = 600, winHeight = 600;
 class Curve
 {
 	Geometry<vec2>* vertices;
+	CurveTessellator tessellator;	// flat within a quarter pixel, at most 4096 vertices
 
 public:
 	Curve() { vertices = new Geometry<vec2>(); }
@@ -43,19 +44,12 @@ public:
 		if (vertices->Vtx().size() >= 2)
 			vertices->Draw(gpuProgram, GL_LINE_STRIP, { 1.0f, 1.0f, 0.0f });
 	}
+	// more vertices where the curve bends in the window, fewer along straight parts
 	void UpdateVertices(vec2(*f)(float))
 	{
-		static const int nTessVertices = 100;
-		
-		vec2 p;
-		float dt = 2.0f / nTessVertices;
-		vertices->Vtx().clear(); vertices->Vtx().reserve(nTessVertices);
-		for (float t = -1.0f; t < 1.0f + dt; t += dt)
-		{
-			p = f(t);
-			vertices->Vtx().push_back(p);
-		}
+		tessellator.Tessellate(f, -1.0f, 1.0f, scale(vec3(winWidth / 2.0f, winHeight / 2.0f, 1.0f)), vertices->Vtx());
 		vertices->updateGPU();
+		printf("%d vertices, %d evaluations\n", tessellator.VertexCount(), tessellator.Evaluations());
 	}
 };
 
@@ -2,6 +2,12 @@
 // Zld hromszg: A framework.h osztlyait felhasznl megolds
 //=============================================================================================
 #include "framework.h"
+#include <algorithm>
+#include <array>
+#include <set>
+#include <thread>
+#include <chrono>
+#include <random>
 
 // cscspont rnyal
 const char* vertSource = R"(
@@ -30,12 +36,327 @@ const char* fragSource = R"(
 
 const int winWidth = 600, winHeight = 600;
 
+// the original O(n h) gift wrapping, kept as reference for the benchmark;
+// in double, as float cosines of the tiny angles in large point sets tie and the walk never closes
+std::vector<vec2> GiftWrapping(const std::vector<vec2>& points)
+{
+	std::vector<vec2> hull;
+	const vec2* pLow = &points[0];
+	for (auto& p : points)
+		if (p.y < pLow->y) pLow = &p;
+
+	dvec2 pCur = *pLow, dir(1, 0);
+	const vec2* pNext = nullptr;
+	do
+	{
+		// find convex hull points one by one
+		double maxCos = -1;
+		for (auto& p : points)
+		{
+			// find minimal left turn
+			double len = length(dvec2(p) - pCur);
+			if (len > 0)
+			{
+				double cosPhi = dot(dir, dvec2(p) - pCur) / len;
+				if (cosPhi > maxCos) { maxCos = cosPhi; pNext = &p; }
+			}
+		}
+		hull.push_back(*pNext); // save as convex hull
+		dir = normalize(dvec2(*pNext) - pCur); // prepare for next
+		pCur = *pNext;
+	} while (pLow != pNext);
+	return hull;
+}
+
+// lexicographic order, x first
+struct LexLess
+{
+	bool operator()(vec2 a, vec2 b) const { return a.x < b.x || (a.x == b.x && a.y < b.y); }
+};
+
+// Andrew's monotone chain, O(n log n)
+std::vector<vec2> MonotoneChain(std::vector<vec2> points)
+{
+	std::sort(points.begin(), points.end(), LexLess());
+	points.erase(std::unique(points.begin(), points.end()), points.end());
+	if (points.size() < 3) return points;
+
+	std::vector<vec2> hull(2 * points.size());
+	int k = 0;
+	for (size_t i = 0; i < points.size(); i++) // lower chain
+	{
+		while (k >= 2 && orient2D(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+		hull[k++] = points[i];
+	}
+	for (int i = (int)points.size() - 2, lower = k + 1; i >= 0; i--) // upper chain
+	{
+		while (k >= lower && orient2D(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
+		hull[k++] = points[i];
+	}
+	hull.resize(k - 1); // the last point is the first one again
+	return hull;
+}
+
+// hull vertices strictly between a and b, from the points in [begin, end) which are all right of a->b
+void QuickHullSide(vec2 a, vec2 b, vec2* begin, vec2* end, std::vector<vec2>& hull)
+{
+	if (begin == end) return;
+
+	// the farthest point from the line is on the hull
+	vec2* farthest = begin;
+	double maxDist = 0.0;
+	for (vec2* p = begin; p != end; p++)
+	{
+		double dist = ((double)b.y - a.y) * ((double)p->x - a.x) - ((double)b.x - a.x) * ((double)p->y - a.y);
+		if (dist > maxDist) { maxDist = dist; farthest = p; }
+	}
+	vec2 c = *farthest;
+
+	// points inside the triangle abc are dropped
+	vec2* mid = std::partition(begin, end, [&](vec2 p) { return orient2D(a, c, p) < 0; });
+	vec2* last = std::partition(mid, end, [&](vec2 p) { return orient2D(c, b, p) < 0; });
+	QuickHullSide(a, c, begin, mid, hull);
+	hull.push_back(c);
+	QuickHullSide(c, b, mid, last, hull);
+}
+
+// QuickHull, O(n log n) expected
+std::vector<vec2> QuickHull(std::vector<vec2> points)
+{
+	if (points.empty()) return points;
+	auto range = std::minmax_element(points.begin(), points.end(), LexLess());
+	vec2 a = *range.first, b = *range.second;
+	if (a == b) return { a };
+
+	vec2* mid = std::partition(points.data(), points.data() + points.size(), [&](vec2 p) { return orient2D(a, b, p) < 0; });
+	vec2* last = std::partition(mid, points.data() + points.size(), [&](vec2 p) { return orient2D(b, a, p) < 0; });
+	if (last == points.data()) return { a, b }; // all on the line ab, the closing pass below would drop b
+
+	std::vector<vec2> hull{ a };
+	QuickHullSide(a, b, points.data(), mid, hull);
+	hull.push_back(b);
+	QuickHullSide(b, a, mid, last, hull);
+
+	// the farthest points were chosen with rounding, drop the ones that do not turn left exactly
+	hull.push_back(a);
+	int k = 1;
+	for (size_t i = 1; i < hull.size(); i++)
+	{
+		vec2 p = hull[i];
+		while (k >= 2 && orient2D(hull[k - 2], hull[k - 1], p) <= 0) k--;
+		hull[k++] = p;
+	}
+	hull.resize(k - 1); // the last point is a again
+	return hull;
+}
+
+// Akl-Toussaint heuristic: the points extreme in the x, y, x + y and x - y directions form an
+// octagon, and the points strictly inside it cannot be on the hull
+std::vector<vec2> AklToussaintFilter(const std::vector<vec2>& points, int nThreads)
+{
+	const size_t minChunk = 1 << 16;
+	nThreads = (int)std::max<size_t>(1, std::min<size_t>(nThreads, points.size() / minChunk));
+	size_t chunk = (points.size() + nThreads - 1) / nThreads;
+	auto parallelFor = [&](auto&& body) {
+		std::vector<std::thread> threads;
+		for (int t = 1; t < nThreads; t++)
+			threads.emplace_back(body, t, t * chunk, std::min(points.size(), (t + 1) * chunk));
+		body(0, 0, std::min(points.size(), chunk));
+		for (auto& thread : threads) thread.join();
+	};
+	// extreme in direction d: 0: -y, 1: x - y, 2: x, 3: x + y, 4: y, 5: y - x, 6: -x, 7: -x - y (counterclockwise)
+	auto extent = [](vec2 p, int d) {
+		const float dx[8] = { 0, 1, 1, 1, 0, -1, -1, -1 }, dy[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+		return (double)p.x * dx[d] + (double)p.y * dy[d];
+	};
+
+	std::vector<std::array<vec2, 8>> extremes(nThreads);
+	parallelFor([&](int t, size_t begin, size_t end) {
+		vec2 ext[8];
+		for (int d = 0; d < 8; d++) ext[d] = points[begin];
+		for (size_t i = begin; i < end; i++)
+			for (int d = 0; d < 8; d++)
+				if (extent(points[i], d) > extent(ext[d], d)) ext[d] = points[i];
+		std::copy(ext, ext + 8, extremes[t].begin());
+	});
+	std::array<vec2, 8> e = extremes[0];
+	vec2 octagon[8];
+	int nVertices = 0;
+	for (int d = 0; d < 8; d++)
+	{
+		for (int t = 1; t < nThreads; t++)
+			if (extent(extremes[t][d], d) > extent(e[d], d)) e[d] = extremes[t][d];
+		if (nVertices == 0 || e[d] != octagon[nVertices - 1]) octagon[nVertices++] = e[d];
+	}
+	if (nVertices > 1 && octagon[nVertices - 1] == octagon[0]) nVertices--;
+	if (nVertices < 3) return points;
+
+	// the open box bounded by the inner coordinates of the three vertices on each side is inside
+	// the octagon, and it holds most of the points
+	float boxMinX = std::max({ e[5].x, e[6].x, e[7].x }), boxMaxX = std::min({ e[1].x, e[2].x, e[3].x });
+	float boxMinY = std::max({ e[7].y, e[0].y, e[1].y }), boxMaxY = std::min({ e[3].y, e[4].y, e[5].y });
+
+	// the surviving points of each thread are appended in thread order
+	std::vector<std::vector<vec2>> kept(nThreads);
+	parallelFor([&](int t, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++)
+		{
+			vec2 p = points[i];
+			if (p.x > boxMinX && p.x < boxMaxX && p.y > boxMinY && p.y < boxMaxY) continue;
+			bool inside = true;
+			for (int v = 0; v < nVertices && inside; v++)
+				inside = orient2D(octagon[v], octagon[(v + 1) % nVertices], p) > 0;
+			if (!inside) kept[t].push_back(p);
+		}
+	});
+	std::vector<vec2> result;
+	for (auto& k : kept) result.insert(result.end(), k.begin(), k.end());
+	return result;
+}
+
+enum HullAlgorithm { HULL_GIFT_WRAPPING, HULL_MONOTONE_CHAIN, HULL_QUICKHULL };
+const char* hullAlgorithmNames[] = { "gift wrapping", "monotone chain", "QuickHull" };
+
+// counterclockwise convex hull, the O(n log n) algorithms run on the prefiltered points
+std::vector<vec2> ConvexHull(const std::vector<vec2>& points, HullAlgorithm algorithm,
+							 int nThreads = (int)std::thread::hardware_concurrency())
+{
+	if (points.empty()) return {};
+	switch (algorithm)
+	{
+	case HULL_MONOTONE_CHAIN: return MonotoneChain(AklToussaintFilter(points, nThreads));
+	case HULL_QUICKHULL:      return QuickHull(AklToussaintFilter(points, nThreads));
+	default:                  return GiftWrapping(points);
+	}
+}
+
+// one monotone chain of a dynamic hull between the lexicographically smallest and largest point:
+// every vertex turns left (lower chain, turn = 1) or right (upper chain, turn = -1)
+class HullChain
+{
+	std::set<vec2, LexLess> vertices;
+	int turn;
+public:
+	HullChain(int turn) : turn(turn) {}
+
+	bool Contains(vec2 p) const { return vertices.count(p) > 0; }
+	const std::set<vec2, LexLess>& Vertices() const { return vertices; }
+
+	// O(log n) amortized: locate p, and if it is outside, remove the neighbours that become reflex
+	void Insert(vec2 p)
+	{
+		auto next = vertices.lower_bound(p);
+		if (next != vertices.end() && *next == p) return;
+		if (next != vertices.begin() && next != vertices.end() && turn * orient2D(*std::prev(next), *next, p) >= 0) return;
+
+		auto it = vertices.insert(next, p);
+		while (std::next(it) != vertices.end() && std::next(it, 2) != vertices.end() &&
+			   turn * orient2D(p, *std::next(it), *std::next(it, 2)) <= 0)
+			vertices.erase(std::next(it));
+		while (it != vertices.begin() && std::prev(it) != vertices.begin() &&
+			   turn * orient2D(*std::prev(it, 2), *std::prev(it), p) <= 0)
+			vertices.erase(std::prev(it));
+	}
+
+	// O(n) from the lexicographically sorted points
+	template <typename Iterator>
+	void Rebuild(Iterator begin, Iterator end)
+	{
+		std::vector<vec2> chain;
+		for (Iterator p = begin; p != end; p++)
+		{
+			if (!chain.empty() && chain.back() == *p) continue;
+			while (chain.size() >= 2 && turn * orient2D(chain[chain.size() - 2], chain.back(), *p) <= 0) chain.pop_back();
+			chain.push_back(*p);
+		}
+		vertices = std::set<vec2, LexLess>(chain.begin(), chain.end());
+	}
+};
+
+// convex hull under point insertion and movement; only a chain that loses a vertex is rebuilt
+class DynamicHull
+{
+	std::multiset<vec2, LexLess> points;
+	HullChain lower = HullChain(1), upper = HullChain(-1);
+public:
+	void Insert(vec2 p)
+	{
+		points.insert(p);
+		lower.Insert(p);
+		upper.Insert(p);
+	}
+
+	void Move(vec2 from, vec2 to)
+	{
+		points.erase(points.find(from));
+		points.insert(to);
+		bool lost = points.count(from) == 0; // a duplicate keeps the vertex in place
+		for (HullChain* chain : { &lower, &upper })
+		{
+			if (lost && chain->Contains(from)) chain->Rebuild(points.begin(), points.end());
+			else chain->Insert(to);
+		}
+	}
+
+	// counterclockwise, starting with the lexicographically smallest point
+	std::vector<vec2> Hull() const
+	{
+		std::vector<vec2> hull(lower.Vertices().begin(), lower.Vertices().end());
+		if (upper.Vertices().size() > 2)
+			hull.insert(hull.end(), std::next(upper.Vertices().rbegin()), std::prev(upper.Vertices().rend()));
+		return hull;
+	}
+};
+
+// randomized self-check: random insert and move sequences, the dynamic hull is compared with MonotoneChain
+// recomputed from scratch after every operation; every other trial uses a coarse grid, so that duplicates
+// and collinear points are frequent; returns the number of mismatches
+int CheckDynamicHull(int nTrials, unsigned int seed, int& nOperations)
+{
+	std::mt19937 rng(seed);
+	int mismatches = 0;
+	nOperations = 0;
+	for (int trial = 0; trial < nTrials; trial++)
+	{
+		int gridSize = (trial % 2 == 0) ? 8 : 100000;
+		std::uniform_int_distribution<int> coord(-gridSize, gridSize);
+		auto randomPoint = [&] { return vec2((float)coord(rng), (float)coord(rng)) / (float)gridSize; };
+
+		std::vector<vec2> points;
+		DynamicHull dynamic;
+		auto check = [&](const char* operation) {
+			nOperations++;
+			if (dynamic.Hull() == MonotoneChain(points)) return;
+			if (mismatches++ == 0) printf("first mismatch: trial %d, %s with %d points\n", trial, operation, (int)points.size());
+		};
+
+		const int nPoints = 1 + trial % 40, nMoves = 100;
+		for (int i = 0; i < nPoints; i++)
+		{
+			points.push_back(randomPoint());
+			dynamic.Insert(points.back());
+			check("insert");
+		}
+		for (int i = 0; i < nMoves; i++)
+		{
+			int k = rng() % points.size();
+			vec2 to = (rng() % 4 == 0) ? points[rng() % points.size()] : randomPoint(); // sometimes onto another point
+			dynamic.Move(points[k], to);
+			points[k] = to;
+			check("move");
+		}
+	}
+	return mismatches;
+}
+
 class ConvexHullApp : public glApp {
 	GPUProgram* gpuProgram;	   // cscspont s pixel rnyalk
 	Geometry<vec2>* points;
 	Geometry<vec2>* hullPoints;
 
 	vec2* draggedVertex = nullptr;
+	HullAlgorithm algorithm = HULL_MONOTONE_CHAIN;
+	DynamicHull dynamicHull; // follows the edits without recomputation
 
 public:
 	ConvexHullApp() : glApp("Convex hull") { }
@@ -63,6 +384,8 @@ public:
 		points->Vtx().reserve(numPoints);
 		for (int i = 0; i < numPoints; i++)
 			points->Vtx().emplace_back((rand() % 1000 / 500.0f - 1.0f) * 0.9f, (rand() % 1000 / 500.0f - 1.0f) * 0.9f);
+		for (auto& p : points->Vtx())
+			dynamicHull.Insert(p);
 
 		Recalculate();
 	}
@@ -85,13 +408,115 @@ public:
 		points->Draw(gpuProgram, GL_POINTS, vec3(1, 0, 0));
 	}
 
+	// space: next algorithm, b: benchmark on 10M random points, p: benchmark of the exact predicates,
+	// t: randomized self-check of the dynamic hull
+	void onKeyboard(int key)
+	{
+		if (key == ' ')
+		{
+			algorithm = (HullAlgorithm)((algorithm + 1) % 3);
+			printf("%s\n", hullAlgorithmNames[algorithm]);
+			Recalculate();
+			refreshScreen();
+		}
+		else if (key == 'b')
+		{
+			const int nPoints = 10000000;
+			std::mt19937 rng(42);
+			std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+			std::vector<vec2> cloud(nPoints);
+			for (auto& p : cloud) p = vec2(coord(rng), coord(rng));
+
+			for (int a = 0; a < 3; a++)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				size_t hullSize = ConvexHull(cloud, (HullAlgorithm)a).size();
+				auto end = std::chrono::high_resolution_clock::now();
+				printf("%s: %d points, %d on hull, %.1f ms\n", hullAlgorithmNames[a], nPoints, (int)hullSize,
+					std::chrono::duration<float, std::milli>(end - start).count());
+			}
+
+			// incremental: the first 1M points one by one, then 10000 of them moved
+			const int nInserts = 1000000, nMoves = 10000;
+			DynamicHull dynamic;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < nInserts; i++) dynamic.Insert(cloud[i]);
+			auto inserted = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < nMoves; i++)
+			{
+				vec2 to(coord(rng), coord(rng));
+				dynamic.Move(cloud[i], to);
+				cloud[i] = to;
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			printf("dynamic hull: %d inserts %.1f ms, %d moves %.1f ms\n",
+				nInserts, std::chrono::duration<float, std::milli>(inserted - start).count(),
+				nMoves, std::chrono::duration<float, std::milli>(end - inserted).count());
+		}
+		else if (key == 't')
+		{
+			int nOperations;
+			auto start = std::chrono::high_resolution_clock::now();
+			int mismatches = CheckDynamicHull(2000, 42, nOperations);
+			auto end = std::chrono::high_resolution_clock::now();
+			printf("dynamic hull self-check: %d operations, %d mismatches, %.1f ms\n", nOperations, mismatches,
+				std::chrono::duration<float, std::milli>(end - start).count());
+		}
+		else if (key == 'p')
+		{
+			// cost of the exact predicates against plain double determinants: on random points the
+			// filter decides, on points of a line or a circle (rounded to float) the exact path runs
+			const int n = 1000000;
+			std::mt19937 rng(42);
+			std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+			std::vector<vec2> random(n + 3), line(n + 3), circle(n + 3);
+			for (int i = 0; i < n + 3; i++)
+			{
+				float t = coord(rng);
+				random[i] = vec2(coord(rng), coord(rng));
+				line[i] = vec2(t, 0.3f * t + 0.1f);
+				circle[i] = vec2(cosf(t * (float)M_PI), sinf(t * (float)M_PI));
+			}
+
+			auto orientDouble = [](vec2 a, vec2 b, vec2 c) {
+				double det = ((double)b.x - a.x) * ((double)c.y - a.y) - ((double)b.y - a.y) * ((double)c.x - a.x);
+				return (det > 0.0) - (det < 0.0);
+			};
+			auto inCircleDouble = [](vec2 a, vec2 b, vec2 c, vec2 d) {
+				dvec2 ad = dvec2(a) - dvec2(d), bd = dvec2(b) - dvec2(d), cd = dvec2(c) - dvec2(d);
+				double det = dot(ad, ad) * (bd.x * cd.y - cd.x * bd.y) + dot(bd, bd) * (cd.x * ad.y - ad.x * cd.y) + dot(cd, cd) * (ad.x * bd.y - bd.x * ad.y);
+				return (det > 0.0) - (det < 0.0);
+			};
+			auto measure = [&](const char* name, const std::vector<vec2>& v, auto predicate) {
+				auto start = std::chrono::high_resolution_clock::now();
+				int sum = 0;
+				for (int i = 0; i < n; i++) sum += predicate(&v[i]);
+				auto end = std::chrono::high_resolution_clock::now();
+				printf("%s: %d tests %.1f ms (sum %d)\n", name, n, std::chrono::duration<float, std::milli>(end - start).count(), sum);
+			};
+			for (auto* v : { &random, &line })
+			{
+				printf("%s points\n", v == &random ? "random" : "collinear");
+				measure("  double orientation", *v, [&](const vec2* p) { return orientDouble(p[0], p[1], p[2]); });
+				measure("  orient2D", *v, [&](const vec2* p) { return orient2D(p[0], p[1], p[2]); });
+			}
+			for (auto* v : { &random, &circle })
+			{
+				printf("%s points\n", v == &random ? "random" : "cocircular");
+				measure("  double incircle", *v, [&](const vec2* p) { return inCircleDouble(p[0], p[1], p[2], p[3]); });
+				measure("  inCircle", *v, [&](const vec2* p) { return inCircle(p[0], p[1], p[2], p[3]); });
+			}
+		}
+	}
+
 	void onMouseMotion(int px, int py)
 	{
 		if (draggedVertex)
 		{
 			vec2 p = ScreenToNDC(px, py);
-			*draggedVertex = vec3(p.x, p.y, 1.0f);
-			Recalculate();
+			dynamicHull.Move(*draggedVertex, p);
+			*draggedVertex = p;
+			hullPoints->Vtx() = dynamicHull.Hull();
 			refreshScreen();
 		}
 	}
@@ -101,7 +526,8 @@ public:
 		if (but == MOUSE_LEFT)
 		{
 			points->Vtx().push_back(ScreenToNDC(pX, pY));
-			Recalculate();
+			dynamicHull.Insert(points->Vtx().back());
+			hullPoints->Vtx() = dynamicHull.Hull();
 			refreshScreen();
 		}
 		else if (but == MOUSE_RIGHT)
@@ -124,32 +550,10 @@ public:
 			draggedVertex = nullptr;
 	}
 
+	// full recomputation with the selected algorithm
 	void Recalculate()
 	{
-		vec2* pLow = &points->Vtx()[0];
-		for (auto& p : points->Vtx())
-			if (p.y < pLow->y) pLow = &p;
-
-		hullPoints->Vtx().clear();
-		vec2 pCur = *pLow, *pNext = nullptr, dir(1, 0);
-		do 
-		{ 
-			// find convex hull points one by one
-			float maxCos = -1;
-			for (auto& p : points->Vtx())
-			{
-				// find minimal left turn
-				float len = length(p - pCur);
-				if (len > 0)
-				{
-					float cosPhi = dot(dir, p - pCur) / len;
-					if (cosPhi > maxCos) { maxCos = cosPhi; pNext = &p; }
-				}
-			}
-			hullPoints->Vtx().push_back(*pNext); // save as convex hull
-			dir = normalize(*pNext - pCur); // prepare for next
-			pCur = *pNext;
-		} while (pLow != pNext);
+		hullPoints->Vtx() = ConvexHull(points->Vtx(), algorithm);
 	}
 
 	vec2 ScreenToNDC(int px, int py)
@@ -0,0 +1,639 @@
+//=============================================================================================
+// Zld hromszg: A framework.h osztlyait felhasznl megolds
+//=============================================================================================
+#include "framework.h"
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+#include <chrono>
+#include <random>
+
+// cscspont rnyal
+const char* vertSource = R"(
+	#version 330				
+    precision highp float;
+
+	layout(location = 0) in vec2 cP;	// 0. bemeneti regiszter
+
+	void main() {
+		gl_Position = vec4(cP.x, cP.y, 0, 1); 	// bemenet mr normalizlt eszkzkoordintkban
+	}
+)";
+
+// pixel rnyal
+const char* fragSource = R"(
+	#version 330
+    precision highp float;
+
+	uniform vec3 color;			// konstans szn
+	out vec4 fragmentColor;		// pixel szn
+
+	void main() {
+		fragmentColor = vec4(color, 1); // RGB -> RGBA
+	}
+)";
+
+const int winWidth = 600, winHeight = 600;
+
+// position along a Hilbert curve of a point of the 2^16 x 2^16 grid
+inline unsigned long long HilbertIndex(unsigned int x, unsigned int y)
+{
+	const unsigned int n = 1u << 16;
+	unsigned long long d = 0;
+	for (unsigned int s = n / 2; s > 0; s /= 2)
+	{
+		unsigned int rx = (x & s) > 0, ry = (y & s) > 0;
+		d += (unsigned long long)s * s * ((3 * rx) ^ ry);
+		if (ry == 0)
+		{
+			if (rx == 1) { x = n - 1 - x; y = n - 1 - y; }
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+//---------------------------
+// Incremental Delaunay triangulation (Bowyer-Watson). Every triangle knows its three neighbors, and
+// the hull edges have ghost triangles with a vertex at infinity, so a point outside the hull needs
+// no special case. A new point is located by walking from the last new triangle, the triangles whose
+// circumcircle contains it (the cavity) are removed, and the hole is filled with a fan around it.
+// The points go in BRIO order: rounds of doubling size in random order, each along a Hilbert curve,
+// so consecutive points are close and the walks are short.
+class BowyerWatson
+{
+	static const int ghost = -1;
+	struct Triangle
+	{
+		int v[3];			// counterclockwise, ghost triangles have one ghost vertex
+		int n[3];			// n[i]: the neighbor opposite to v[i]
+		int stamp = 0;		// last insertion that put it in the cavity, -1 if free
+	};
+	std::vector<vec2> p;
+	std::vector<Triangle> triangles;
+	std::vector<int> freeTriangles, cavity, fan, fanStart;
+	int last = -1;			// walks start here, -1 while there is no triangle
+	int stamp = 0;
+	std::mt19937 rng;
+
+	bool IsGhost(const Triangle& t) const { return t.v[0] == ghost || t.v[1] == ghost || t.v[2] == ghost; }
+
+	// the circumcircle of t contains q; for a ghost triangle the open half-plane beyond its hull edge and the open edge
+	bool Conflict(const Triangle& t, vec2 q) const
+	{
+		int g = t.v[0] == ghost ? 0 : t.v[1] == ghost ? 1 : t.v[2] == ghost ? 2 : -1;
+		if (g < 0) return inCircle(p[t.v[0]], p[t.v[1]], p[t.v[2]], q) > 0;
+		vec2 a = p[t.v[(g + 1) % 3]], b = p[t.v[(g + 2) % 3]];
+		int o = orient2D(a, b, q);
+		if (o != 0) return o > 0;
+		return a.x != b.x ? (q.x > min(a.x, b.x) && q.x < max(a.x, b.x)) : (q.y > min(a.y, b.y) && q.y < max(a.y, b.y));
+	}
+
+	int NewTriangle(int a, int b, int c)
+	{
+		int t;
+		if (!freeTriangles.empty()) { t = freeTriangles.back(); freeTriangles.pop_back(); }
+		else { t = (int)triangles.size(); triangles.emplace_back(); }
+		triangles[t] = { { a, b, c }, { -1, -1, -1 }, 0 };
+		return t;
+	}
+
+	// visibility walk: cross an edge that has q on its other side, starting with a random edge
+	int Locate(vec2 q) const
+	{
+		int t = last;
+		if (IsGhost(triangles[t]))
+			for (int i = 0; i < 3; i++)
+				if (triangles[t].v[i] == ghost) t = triangles[t].n[i]; // the real triangle of the hull edge
+		unsigned int r = (unsigned int)t;
+		while (!IsGhost(triangles[t]))
+		{
+			const Triangle& tri = triangles[t];
+			int next = -1;
+			r = r * 1103515245u + 12345u;
+			for (int k = 0, i = (r >> 16) % 3; k < 3; k++, i = (i + 1) % 3)
+				if (orient2D(p[tri.v[(i + 1) % 3]], p[tri.v[(i + 2) % 3]], q) < 0) { next = tri.n[i]; break; }
+			if (next < 0) return t;
+			t = next;
+		}
+		return t; // q is beyond a hull edge
+	}
+
+	// first triangle and its three ghosts from the first three points of order that are not collinear
+	bool Start(std::vector<int>& order)
+	{
+		size_t b = 1, c;
+		while (b < order.size() && p[order[b]] == p[order[0]]) b++;
+		for (c = b + 1; c < order.size() && orient2D(p[order[0]], p[order[b]], p[order[c]]) == 0; c++);
+		if (c >= order.size()) return false;
+		std::swap(order[1], order[b]);
+		std::swap(order[2], order[c]);
+
+		int v[3] = { order[0], order[1], order[2] };
+		if (orient2D(p[v[0]], p[v[1]], p[v[2]]) < 0) std::swap(v[1], v[2]);
+		int t = NewTriangle(v[0], v[1], v[2]);
+		int g[3];
+		for (int i = 0; i < 3; i++) g[i] = NewTriangle(v[(i + 2) % 3], v[(i + 1) % 3], ghost); // across the edge opposite v[i]
+		for (int i = 0; i < 3; i++)
+		{
+			triangles[t].n[i] = g[i];
+			triangles[g[i]].n[2] = t;
+			triangles[g[i]].n[0] = g[(i + 2) % 3]; // across (v[i + 1], ghost)
+			triangles[g[i]].n[1] = g[(i + 1) % 3]; // across (ghost, v[i + 2])
+		}
+		last = t;
+		return true;
+	}
+
+	// false for a duplicate point
+	bool Insert(int i)
+	{
+		vec2 q = p[i];
+		int t = Locate(q);
+		const Triangle& located = triangles[t];
+		for (int k = 0; k < 3; k++)
+			if (located.v[k] != ghost && p[located.v[k]] == q) return false;
+
+		// cavity: the connected triangles in conflict with q
+		stamp++;
+		cavity.assign(1, t);
+		triangles[t].stamp = stamp;
+		for (size_t c = 0; c < cavity.size(); c++)
+			for (int k = 0; k < 3; k++)
+			{
+				int nb = triangles[cavity[c]].n[k];
+				if (triangles[nb].stamp != stamp && Conflict(triangles[nb], q))
+				{
+					triangles[nb].stamp = stamp;
+					cavity.push_back(nb);
+				}
+			}
+
+		// fan of q over the boundary edges of the cavity
+		if (fanStart.size() < p.size() + 1) fanStart.resize(p.size() + 1);
+		fan.clear();
+		for (int c : cavity)
+		{
+			Triangle old = triangles[c]; // NewTriangle may move the triangles
+			for (int k = 0; k < 3; k++)
+			{
+				int nb = old.n[k];
+				if (triangles[nb].stamp == stamp) continue;
+				int a = old.v[(k + 1) % 3], b = old.v[(k + 2) % 3];
+				int f = NewTriangle(a, b, i);
+				triangles[f].n[2] = nb;
+				Triangle& outer = triangles[nb];
+				for (int j = 0; j < 3; j++)
+					if (outer.v[j] != a && outer.v[j] != b) outer.n[j] = f;
+				fanStart[a + 1] = f; // the ghost is -1
+				fan.push_back(f);
+			}
+		}
+		for (int c : cavity)
+		{
+			triangles[c].stamp = -1;
+			freeTriangles.push_back(c);
+		}
+
+		// around q: (a, b, q) and (b, c, q) are neighbors across (b, q)
+		for (int f : fan)
+		{
+			int next = fanStart[triangles[f].v[1] + 1];
+			triangles[f].n[0] = next;
+			triangles[next].n[1] = f;
+		}
+		last = fan.back();
+		return true;
+	}
+	std::vector<int> BrioOrder()
+	{
+		std::vector<int> order(p.size());
+		for (int i = 0; i < (int)order.size(); i++) order[i] = i;
+		std::shuffle(order.begin(), order.end(), rng);
+		if (p.empty()) return order;
+
+		vec2 lo = p[0], hi = p[0];
+		for (vec2 q : p) { lo = min(lo, q); hi = max(hi, q); }
+		vec2 scale = 65535.0f / max(hi - lo, vec2(1e-30f));
+		std::vector<unsigned long long> key(p.size());
+		for (size_t i = 0; i < p.size(); i++)
+		{
+			uvec2 cell = uvec2((p[i] - lo) * scale);
+			key[i] = HilbertIndex(cell.x, cell.y);
+		}
+		for (size_t end = order.size(); end > 0; )
+		{
+			size_t begin = end > 256 ? end / 2 : 0;
+			std::sort(order.begin() + begin, order.begin() + end, [&](int a, int b) { return key[a] < key[b]; });
+			end = begin;
+		}
+		return order;
+	}
+
+public:
+	BowyerWatson() : rng(12345) {}
+
+	// counterclockwise Delaunay triangles as indices of the points, duplicate points are left out
+	std::vector<unsigned int> Triangulate(const std::vector<vec2>& points)
+	{
+		Clear();
+		p = points;
+		std::vector<int> order = BrioOrder();
+		if (Start(order))
+			for (size_t k = 3; k < order.size(); k++) Insert(order[k]);
+		return Triangles();
+	}
+
+	// one more point into the current triangulation
+	void Add(vec2 q)
+	{
+		p.push_back(q);
+		if (last >= 0)
+		{
+			Insert((int)p.size() - 1);
+			return;
+		}
+		std::vector<int> order(p.size());
+		for (int i = 0; i < (int)order.size(); i++) order[i] = i;
+		if (Start(order))
+			for (size_t k = 3; k < order.size(); k++) Insert(order[k]);
+	}
+
+	void Clear()
+	{
+		p.clear();
+		triangles.clear();
+		freeTriangles.clear();
+		last = -1;
+	}
+
+	std::vector<unsigned int> Triangles() const
+	{
+		std::vector<unsigned int> indices;
+		for (const Triangle& t : triangles)
+			if (t.stamp >= 0 && !IsGhost(t))
+				indices.insert(indices.end(), { (unsigned int)t.v[0], (unsigned int)t.v[1], (unsigned int)t.v[2] });
+		return indices;
+	}
+};
+
+//---------------------------
+// Divide and conquer Delaunay triangulation (Guibas-Stolfi) on a quad-edge structure: the points
+// sorted by x are halved, both halves are triangulated, and the two are zipped together from their
+// lower common tangent upwards. The top levels of the recursion run on separate threads, each
+// allocating the edges from its own pool.
+class DivideAndConquerDelaunay
+{
+	struct Edge
+	{
+		Edge* next;		// counterclockwise around the origin (Onext)
+		int org;		// origin vertex, -1 for a deleted edge
+	};
+	struct alignas(4 * sizeof(Edge)) QuadEdge { Edge e[4]; }; // the index in the quad-edge is in the address
+	struct Pool
+	{
+		std::deque<QuadEdge> edges; // pointers to the elements stay valid while it grows
+		std::vector<QuadEdge*> free;
+	};
+
+	std::vector<vec2> q;		// the distinct points sorted by x, then y
+	std::vector<int> sorted;	// their indices in the input
+	std::vector<Pool> pools;
+
+	static int R(Edge* e) { return int((uintptr_t)e / sizeof(Edge)) & 3; }
+	static Edge* Rot(Edge* e) { return R(e) < 3 ? e + 1 : e - 3; }
+	static Edge* InvRot(Edge* e) { return R(e) > 0 ? e - 1 : e + 3; }
+	static Edge* Sym(Edge* e) { return R(e) < 2 ? e + 2 : e - 2; }
+	static Edge* Oprev(Edge* e) { return Rot(Rot(e)->next); }
+	static Edge* Lnext(Edge* e) { return Rot(InvRot(e)->next); }
+	static Edge* Rprev(Edge* e) { return Sym(e)->next; }
+	static int Dest(Edge* e) { return Sym(e)->org; }
+
+	vec2 P(int v) const { return q[v]; }
+	bool RightOf(int v, Edge* e) const { return orient2D(P(v), P(Dest(e)), P(e->org)) > 0; }
+	bool LeftOf(int v, Edge* e) const { return orient2D(P(v), P(e->org), P(Dest(e))) > 0; }
+
+	static Edge* MakeEdge(Pool& pool, int org, int dest)
+	{
+		QuadEdge* q;
+		if (!pool.free.empty()) { q = pool.free.back(); pool.free.pop_back(); }
+		else q = &pool.edges.emplace_back();
+		for (int r = 0; r < 4; r++) q->e[r] = { nullptr, -1 };
+		q->e[0].next = &q->e[0];
+		q->e[1].next = &q->e[3];
+		q->e[2].next = &q->e[2];
+		q->e[3].next = &q->e[1];
+		q->e[0].org = org;
+		q->e[2].org = dest;
+		return &q->e[0];
+	}
+
+	static void Splice(Edge* a, Edge* b)
+	{
+		Edge* alpha = Rot(a->next), * beta = Rot(b->next);
+		std::swap(a->next, b->next);
+		std::swap(alpha->next, beta->next);
+	}
+
+	// new edge from the destination of a to the origin of b, in the same left face
+	static Edge* Connect(Pool& pool, Edge* a, Edge* b)
+	{
+		Edge* e = MakeEdge(pool, Dest(a), b->org);
+		Splice(e, Lnext(a));
+		Splice(Sym(e), b);
+		return e;
+	}
+
+	static void DeleteEdge(Pool& pool, Edge* e)
+	{
+		Splice(e, Oprev(e));
+		Splice(Sym(e), Oprev(Sym(e)));
+		QuadEdge* q = (QuadEdge*)(e - R(e));
+		q->e[0].org = q->e[2].org = -1;
+		pool.free.push_back(q);
+	}
+
+	// triangulation of q[lo, hi): the counterclockwise hull edge out of the leftmost point,
+	// and the clockwise hull edge out of the rightmost point
+	std::pair<Edge*, Edge*> Build(int lo, int hi, int pool, int depth)
+	{
+		Pool& edges = pools[pool];
+		int n = hi - lo;
+		if (n == 2)
+		{
+			Edge* a = MakeEdge(edges, lo, lo + 1);
+			return { a, Sym(a) };
+		}
+		if (n == 3)
+		{
+			int s1 = lo, s2 = lo + 1, s3 = lo + 2;
+			Edge* a = MakeEdge(edges, s1, s2);
+			Edge* b = MakeEdge(edges, s2, s3);
+			Splice(Sym(a), b);
+			int turn = orient2D(P(s1), P(s2), P(s3));
+			if (turn == 0) return { a, Sym(b) };
+			Edge* c = Connect(edges, b, a);
+			return turn > 0 ? std::make_pair(a, Sym(b)) : std::make_pair(Sym(c), c);
+		}
+
+		int mid = lo + n / 2;
+		std::pair<Edge*, Edge*> left, right;
+		if (depth > 0 && n > 50000)
+		{
+			std::thread worker([&] { left = Build(lo, mid, pool, depth - 1); });
+			right = Build(mid, hi, pool + (1 << (depth - 1)), depth - 1);
+			worker.join();
+		}
+		else
+		{
+			left = Build(lo, mid, pool, depth - 1);
+			right = Build(mid, hi, pool, depth - 1);
+		}
+		auto [ldo, ldi] = left;
+		auto [rdi, rdo] = right;
+
+		// lower common tangent
+		for (;;)
+		{
+			if (LeftOf(rdi->org, ldi)) ldi = Lnext(ldi);
+			else if (RightOf(ldi->org, rdi)) rdi = Rprev(rdi);
+			else break;
+		}
+		Edge* basel = Connect(edges, Sym(rdi), ldi);
+		if (ldi->org == ldo->org) ldo = Sym(basel);
+		if (rdi->org == rdo->org) rdo = basel;
+
+		// zip upwards: the next edge goes to the left or the right candidate, whose circle is empty
+		for (;;)
+		{
+			auto valid = [&](Edge* e) { return RightOf(Dest(e), basel); };
+			Edge* lcand = Sym(basel)->next;
+			if (valid(lcand))
+				while (inCircle(P(Dest(basel)), P(basel->org), P(Dest(lcand)), P(Dest(lcand->next))) > 0)
+				{
+					Edge* t = lcand->next;
+					DeleteEdge(edges, lcand);
+					lcand = t;
+				}
+			Edge* rcand = Oprev(basel);
+			if (valid(rcand))
+				while (inCircle(P(Dest(basel)), P(basel->org), P(Dest(rcand)), P(Dest(Oprev(rcand)))) > 0)
+				{
+					Edge* t = Oprev(rcand);
+					DeleteEdge(edges, rcand);
+					rcand = t;
+				}
+			if (!valid(lcand) && !valid(rcand)) break;
+			if (!valid(lcand) || (valid(rcand) && inCircle(P(Dest(lcand)), P(lcand->org), P(rcand->org), P(Dest(rcand))) > 0))
+				basel = Connect(edges, rcand, Sym(basel));
+			else
+				basel = Connect(edges, Sym(basel), Sym(lcand));
+		}
+		return { ldo, rdo };
+	}
+
+public:
+	// counterclockwise Delaunay triangles as indices of the points, duplicate points are left out
+	std::vector<unsigned int> Triangulate(const std::vector<vec2>& points, int nThreads = (int)std::thread::hardware_concurrency())
+	{
+		sorted.resize(points.size());
+		for (int i = 0; i < (int)sorted.size(); i++) sorted[i] = i;
+		std::sort(sorted.begin(), sorted.end(), [&](int a, int b) { return points[a].x < points[b].x || (points[a].x == points[b].x && points[a].y < points[b].y); });
+		sorted.erase(std::unique(sorted.begin(), sorted.end(), [&](int a, int b) { return points[a] == points[b]; }), sorted.end());
+		if (sorted.size() < 3) return {};
+		q.resize(sorted.size());
+		for (size_t i = 0; i < sorted.size(); i++) q[i] = points[sorted[i]]; // in sweep order for the cache
+
+		int depth = 0;
+		while ((2 << depth) <= nThreads) depth++;
+		pools.clear();
+		pools.resize(1 << depth);
+		Build(0, (int)sorted.size(), 0, depth);
+
+		// every triangle is the left face of three edges, the hull is a clockwise face;
+		// the dual edges (unused here) mark the visited edges
+		std::vector<unsigned int> indices;
+		for (Pool& pool : pools)
+			for (QuadEdge& quad : pool.edges)
+				for (int r = 0; r < 4; r += 2)
+				{
+					Edge* e = &quad.e[r];
+					if (e->org < 0 || Rot(e)->org >= 0) continue;
+					Edge* e1 = Lnext(e), * e2 = Lnext(e1);
+					if (Lnext(e2) != e) continue;
+					Rot(e)->org = Rot(e1)->org = Rot(e2)->org = 0;
+					if (orient2D(P(e->org), P(e1->org), P(e2->org)) > 0)
+						indices.insert(indices.end(), { (unsigned int)sorted[e->org], (unsigned int)sorted[e1->org], (unsigned int)sorted[e2->org] });
+				}
+		pools.clear();
+		return indices;
+	}
+};
+
+// check of a triangulation for the tests: counterclockwise triangles, every inner edge locally Delaunay
+// (the opposite vertex of the neighbor is not inside the circumcircle), a convex hull, and as many
+// triangles as a triangulation of the distinct points must have
+bool IsDelaunay(const std::vector<vec2>& points, const std::vector<unsigned int>& triangles)
+{
+	std::vector<vec2> distinct(points);
+	std::sort(distinct.begin(), distinct.end(), [](vec2 a, vec2 b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+	distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+	if (triangles.empty()) // only for collinear points
+	{
+		for (vec2 p : distinct)
+			if (orient2D(distinct.front(), distinct.back(), p) != 0) return false;
+		return true;
+	}
+
+	std::unordered_map<unsigned long long, unsigned int> opposite; // directed edge -> third vertex
+	auto key = [](unsigned int a, unsigned int b) { return (unsigned long long)a << 32 | b; };
+	for (size_t t = 0; t + 2 < triangles.size(); t += 3)
+	{
+		unsigned int v[3] = { triangles[t], triangles[t + 1], triangles[t + 2] };
+		if (orient2D(points[v[0]], points[v[1]], points[v[2]]) <= 0) return false;
+		for (int i = 0; i < 3; i++)
+			if (!opposite.emplace(key(v[i], v[(i + 1) % 3]), v[(i + 2) % 3]).second) return false; // an edge used twice
+	}
+
+	std::unordered_map<unsigned int, unsigned int> hullNext;
+	for (auto [edge, c] : opposite)
+	{
+		unsigned int a = (unsigned int)(edge >> 32), b = (unsigned int)edge;
+		auto twin = opposite.find(key(b, a));
+		if (twin == opposite.end()) hullNext[a] = b; // hull edge, counterclockwise
+		else if (inCircle(points[a], points[b], points[c], points[twin->second]) > 0) return false;
+	}
+	for (auto [a, b] : hullNext)
+	{
+		auto next = hullNext.find(b);
+		if (next == hullNext.end() || orient2D(points[a], points[b], points[next->second]) < 0) return false;
+	}
+	return triangles.size() / 3 == 2 * distinct.size() - hullNext.size() - 2;
+}
+
+enum DelaunayEngine { DELAUNAY_BOWYER_WATSON, DELAUNAY_DIVIDE_AND_CONQUER };
+const char* delaunayEngineNames[] = { "Bowyer-Watson", "divide and conquer" };
+
+class DelaunayTriangulationApp : public glApp {
+	GPUProgram* gpuProgram;	   // cscspont s pixel rnyalk
+	Geometry<vec2>* points;
+	Geometry<vec2>* mesh;	// the same points, indexed by the triangles
+
+	DelaunayEngine engine = DELAUNAY_BOWYER_WATSON;
+	BowyerWatson bowyerWatson; // follows the clicks incrementally
+	DivideAndConquerDelaunay divideAndConquer;
+
+public:
+	DelaunayTriangulationApp() : glApp("Delaunay triangulation") { }
+	~DelaunayTriangulationApp()
+	{
+		delete points;
+		delete mesh;
+
+		delete gpuProgram;
+	}
+
+	// Inicializci, 
+	void onInitialization()
+	{
+		glLineWidth(1.0f);
+		glPointSize(6.0f);
+
+		gpuProgram = new GPUProgram(vertSource, fragSource);
+
+		points = new Geometry<vec2>();
+		mesh = new Geometry<vec2>();
+
+		srand(time(NULL));
+		const int numPoints = 50;
+		points->Vtx().reserve(numPoints);
+		for (int i = 0; i < numPoints; i++)
+			points->Vtx().emplace_back((rand() % 1000 / 500.0f - 1.0f) * 0.9f, (rand() % 1000 / 500.0f - 1.0f) * 0.9f);
+
+		Recalculate();
+	}
+
+	// Ablak jrarajzols
+	void onDisplay()
+	{
+		glClearColor(0, 0, 0, 0);     // httr szn
+		glClear(GL_COLOR_BUFFER_BIT); // rasztertr trls
+		glViewport(0, 0, winWidth, winHeight);
+
+		if (mesh->Idx().size() > 0)
+		{
+			mesh->updateGPU();
+			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+			mesh->Draw(gpuProgram, GL_TRIANGLES, vec3(0.0f, 1.0f, 1.0f));
+			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		}
+
+		points->updateGPU();
+		points->Draw(gpuProgram, GL_POINTS, vec3(1, 0, 0));
+	}
+
+	// space: next engine, b: benchmark on 1M random points
+	void onKeyboard(int key)
+	{
+		if (key == ' ')
+		{
+			engine = (DelaunayEngine)((engine + 1) % 2);
+			printf("%s\n", delaunayEngineNames[engine]);
+			Recalculate();
+			refreshScreen();
+		}
+		else if (key == 'b')
+		{
+			const int nPoints = 1000000;
+			std::mt19937 rng(42);
+			std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+			std::vector<vec2> cloud(nPoints);
+			for (auto& p : cloud) p = vec2(coord(rng), coord(rng));
+
+			int nThreads = (int)std::thread::hardware_concurrency();
+			for (int run = 0; run < 3; run++)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				BowyerWatson incremental;
+				std::vector<unsigned int> triangles = run == 0 ? incremental.Triangulate(cloud) : divideAndConquer.Triangulate(cloud, run == 1 ? 1 : nThreads);
+				auto end = std::chrono::high_resolution_clock::now();
+				printf("%s (%d threads): %d points, %d triangles, %.1f ms, %s\n", delaunayEngineNames[run == 0 ? 0 : 1], run == 2 ? nThreads : 1,
+					nPoints, (int)triangles.size() / 3, std::chrono::duration<float, std::milli>(end - start).count(),
+					IsDelaunay(cloud, triangles) ? "valid" : "NOT DELAUNAY");
+			}
+		}
+	}
+
+	void onMousePressed(MouseButton but, int pX, int pY)
+	{
+		if (but == MOUSE_LEFT)
+		{
+			points->Vtx().push_back(ScreenToNDC(pX, pY));
+			if (engine == DELAUNAY_BOWYER_WATSON)
+			{
+				bowyerWatson.Add(points->Vtx().back());
+				mesh->Vtx() = points->Vtx();
+				mesh->Idx() = bowyerWatson.Triangles();
+			}
+			else Recalculate();
+			refreshScreen();
+		}
+	}
+
+	// full triangulation with the selected engine
+	void Recalculate()
+	{
+		mesh->Vtx() = points->Vtx();
+		mesh->Idx() = engine == DELAUNAY_BOWYER_WATSON ? bowyerWatson.Triangulate(points->Vtx()) : divideAndConquer.Triangulate(points->Vtx());
+	}
+
+	vec2 ScreenToNDC(int px, int py)
+	{
+		float x = (2.0f * px / winWidth) - 1.0f;
+		float y = 1.0f - (2.0f * py / winHeight);
+		return { x, y };
+	}
+};
+
+DelaunayTriangulationApp app;
@@ -208,8 +208,6 @@ struct VtxData
 
 class ParamSurface : public Geometry<VtxData>
 {
-	int nVtxInStrip, nStrips;
-	
 	float rotAngle;
 	vec3 translation, rotAxis, scaling;
 
@@ -221,17 +219,15 @@ public:
 	virtual VtxData GenVtxData(float u, float v) = 0;
 	void create(int M, int N)
 	{
-		nVtxInStrip = (M + 1) * 2;
-		nStrips = N;
 		vtx.clear();
-		for (int i = 0; i < N; i++) 
+		for (int i = 0; i <= N; i++) 
 		{
 			for (int j = 0; j <= M; j++) 
 			{
 				vtx.push_back(GenVtxData((float)j / M, (float)i / N));
-				vtx.push_back(GenVtxData((float)j / M, (float)(i + 1) / N));
 			}
 		}
+		GridStrips(N, M); // every grid vertex once, the strips index them
 		glEnableVertexAttribArray(0); // 0. regiszter = pozci
 		glEnableVertexAttribArray(1); // 1. regiszter = norml vektor
 		glEnableVertexAttribArray(2); // 2. regiszter = textra koordinta
@@ -259,9 +255,7 @@ public:
 		gpuProgram->setUniform(material.ka, "ka");
 		gpuProgram->setUniform(material.shine, "shine");
 
-		Bind();
-		for (unsigned int i = 0; i < nStrips; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, i * nVtxInStrip, nVtxInStrip);
+		DrawStrips();
 	}
 };
 
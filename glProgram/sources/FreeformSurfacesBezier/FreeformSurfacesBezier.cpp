@@ -2,6 +2,7 @@
 // Freeform Surfaces - Bzier
 //=============================================================================================
 #include "framework.h"
+#include <array>
 
 // Phong shader (per-pixel shading)
 const char* vertSourcePhong = R"(
@@ -53,6 +54,101 @@ const char* fragSourcePhong = R"(
 	}
 )";
 
+// Hardware tessellation: the control points are the patch vertices, the surface is evaluated on the GPU.
+// The control and evaluation shaders get the ShaderHeader of the surface with R, C, NCP = R * C and MAXN = max(R, C).
+const char* vertSourcePatch = R"(
+	#version 400
+    precision highp float;
+
+	layout(location = 0) in vec3 vtxPos; // control point in model sp
+
+	void main() {
+		gl_Position = vec4(vtxPos, 1);
+	}
+)";
+const char* tescSourcePatch = R"(
+    precision highp float;
+
+	layout(vertices = NCP) out;
+
+	uniform mat4 MVP;
+	uniform vec2 viewportSize; // pixels
+	uniform float pixelsPerSegment; // target edge length on screen
+
+	vec2 ToPixels(vec4 p) { return p.xy / max(p.w, 0.0001) * 0.5 * viewportSize; }
+
+	// the control polygon of a boundary curve is at least as long as the curve
+	float EdgeLevel(int first, int stride, int n) {
+		float len = 0;
+		vec2 prev = ToPixels(MVP * gl_in[first].gl_Position);
+		for (int k = 1; k < n; k++) {
+			vec2 p = ToPixels(MVP * gl_in[first + k * stride].gl_Position);
+			len += length(p - prev);
+			prev = p;
+		}
+		return clamp(len / pixelsPerSegment, 1, 64);
+	}
+
+	void main() {
+		gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;
+		if (gl_InvocationID == 0) {
+			// gl_TessCoord = (u, v): u goes along the rows i, v along the columns j of cps[i * C + j]
+			gl_TessLevelOuter[0] = EdgeLevel(0, 1, C);				// u = 0
+			gl_TessLevelOuter[1] = EdgeLevel(0, C, R);				// v = 0
+			gl_TessLevelOuter[2] = EdgeLevel((R - 1) * C, 1, C);	// u = 1
+			gl_TessLevelOuter[3] = EdgeLevel(C - 1, C, R);			// v = 1
+			gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+			gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+		}
+	}
+)";
+const char* teseSourcePatch = R"(
+    precision highp float;
+
+	layout(quads, equal_spacing, ccw) in;
+
+	uniform mat4 MVP, M, Minv; // MVP, Model, Model-inverse
+	uniform vec4 wLiPos; // pos of light source
+	uniform vec3 wEye; // pos of eye
+
+	out vec3 wNormal; // normal in world space
+	out vec3 wView; // view in world space
+	out vec3 wLight; // light dir in world space
+
+	// Bernstein polynomials of degree n - 1 and their derivatives, raising the degree one at a time
+	void Basis(int n, float t, out float b[MAXN], out float d[MAXN]) {
+		for (int i = 0; i < MAXN; i++) { b[i] = 0; d[i] = 0; }
+		b[0] = 1;
+		for (int k = 1; k < n; k++) {
+			if (k == n - 1) // b holds degree n - 2
+				for (int i = 0; i < n; i++) d[i] = float(n - 1) * ((i > 0 ? b[i - 1] : 0) - b[i]);
+			for (int i = k; i > 0; i--) b[i] = (1 - t) * b[i] + t * b[i - 1];
+			b[0] *= 1 - t;
+		}
+	}
+
+	void main() {
+		float bu[MAXN], du[MAXN], bv[MAXN], dv[MAXN];
+		Basis(R, gl_TessCoord.x, bu, du);
+		Basis(C, gl_TessCoord.y, bv, dv);
+
+		vec3 pos = vec3(0), dPdu = vec3(0), dPdv = vec3(0);
+		for (int i = 0; i < R; i++)
+			for (int j = 0; j < C; j++) {
+				vec3 cp = gl_in[i * C + j].gl_Position.xyz;
+				pos += bu[i] * bv[j] * cp;
+				dPdu += du[i] * bv[j] * cp;
+				dPdv += bu[i] * dv[j] * cp;
+			}
+
+		gl_Position = MVP * vec4(pos, 1); // to NDC
+		vec4 wPos = M * vec4(pos, 1);
+		wLight = wLiPos.xyz * wPos.w - wPos.xyz * wLiPos.w;
+		wView = wEye - wPos.xyz / wPos.w;
+		wNormal = (vec4(cross(dPdu, dPdv), 0) * Minv).xyz;
+	}
+)";
+
 // Basic shader
 const char* vertSourceBasic = R"(
 	#version 330				
@@ -80,7 +176,8 @@ const char* fragSourceBasic = R"(
 )";
 
 const int tessellationLevel = 20;
-const float eps = 0.0001f;
+const float tessellationPixels = 8.0f; // hardware tessellation: target edge length on screen
+
 const float pickDelta = 0.1f;
 
 const int winWidth = 600, winHeight = 600;
@@ -122,10 +219,20 @@ struct VertexData
 template<unsigned R, unsigned C>
 class BezierSurface : public Geometry<VertexData>
 {
+	static_assert(R * C <= 32, "a patch has at least 32 vertices on every OpenGL 4 implementation");
+
 	int nVtxPerStrip, nStrips;
 	Geometry<vec3>* controlPoints;
+	bool hardwareTessellation = true; // or the CPU mesh of tessellationLevel x tessellationLevel quads
+
+	// CPU mesh: the Bernstein polynomials and their derivatives at the u and v samples of the grid,
+	// and the position and partial derivatives at every grid point (v major), which a drag updates in place
+	std::vector<std::array<float, R>> Bu, dBu;
+	std::vector<std::array<float, C>> Bv, dBv;
+	std::vector<vec3> gridPos, gridDu, gridDv;
 
 public:
+	float pixelsPerSegment = tessellationPixels;
 	float rotAngle;
 	vec3 translation, rotAxis, scaling;
 
@@ -151,43 +258,85 @@ public:
 
 	std::vector<vec3>& Cps() { return controlPoints->Vtx(); };
 
-	vec3 evalPoint(float u, float v)
+	// the tessellation shaders are compiled for R x C control points
+	static std::string ShaderHeader()
+	{
+		return "#version 400\n#define R " + std::to_string(R) + "\n#define C " + std::to_string(C) +
+			"\n#define NCP " + std::to_string(R * C) + "\n#define MAXN " + std::to_string(R > C ? R : C) + "\n";
+	}
+
+	bool IsHardwareTessellation() const { return hardwareTessellation; }
+	void SetHardwareTessellation(bool _hardwareTessellation)
+	{
+		hardwareTessellation = _hardwareTessellation;
+		if (!hardwareTessellation) Update(); // the drags only moved the control points
+	}
+
+	// a drag uploads one control point (12 bytes) with hardware tessellation; the CPU mesh gets
+	// B_i(u) * B_j(v) * delta added to every grid point, and the partial derivatives likewise
+	void MoveControlPoint(int k, vec3 p)
 	{
 		auto& cps = controlPoints->Vtx();
-		vec3 point(0.0f);
-		for (int i = 0; i < R; i++)
-		{
-			float Bu = B(i, R - 1, u);
-			for (int j = 0; j < C; j++)
+		vec3 delta = p - cps[k];
+		cps[k] = p;
+		controlPoints->updateGPU(k, 1);
+		if (hardwareTessellation) return;
+
+		int i = k / C, j = k % C;
+		for (int iv = 0; iv < Bv.size(); iv++)
+			for (int ju = 0; ju < Bu.size(); ju++)
 			{
-				float Bv = B(j, C - 1, v);
-				point += Bu * Bv * cps[i * C + j];
+				int g = iv * (int)Bu.size() + ju;
+				gridPos[g] += (Bu[ju][i] * Bv[iv][j]) * delta;
+				gridDu[g] += (dBu[ju][i] * Bv[iv][j]) * delta;
+				gridDv[g] += (Bu[ju][i] * dBv[iv][j]) * delta;
 			}
-		}
-		return point;
-	}
-	vec3 evalNormal(float u, float v)
-	{
-		vec3 du = evalPoint(u + eps, v) - evalPoint(u - eps, v);
-		vec3 dv = evalPoint(u, v + eps) - evalPoint(u, v - eps);
-		return normalize(cross(du, dv));
+		GenStrips();
 	}
 
-	VertexData GenVertexData(float u, float v) { return { evalPoint(u, v), evalNormal(u, v) }; }
+	// the CPU mesh from scratch, N strips of M quads: u = j / M, v = i / N; the drags accumulate
+	// rounding errors, so this is also called at the end of a drag
 	void Update(int N = tessellationLevel, int M = tessellationLevel)
 	{
 		controlPoints->updateGPU();
 
-		nVtxPerStrip = (M + 1) * 2;
-		nStrips = N;
-		vtx.clear();
-		for (int i = 0; i < N; i++) {
-			for (int j = 0; j <= M; j++) {
-				vtx.push_back(GenVertexData((float)j / M, (float)i / N));
-				vtx.push_back(GenVertexData((float)j / M, (float)(i + 1) / N));
-			}
+		if (Bu.size() != M + 1 || Bv.size() != N + 1)
+		{
+			Bu.resize(M + 1); dBu.resize(M + 1);
+			for (int j = 0; j <= M; j++) Bernstein<R>((float)j / M, Bu[j], dBu[j]);
+			Bv.resize(N + 1); dBv.resize(N + 1);
+			for (int i = 0; i <= N; i++) Bernstein<C>((float)i / N, Bv[i], dBv[i]);
 		}
-		updateGPU();
+
+		// separable: the columns of the control grid are summed along u once per u sample
+		auto& cps = controlPoints->Vtx();
+		std::vector<std::array<vec3, C>> columns(M + 1), dColumns(M + 1);
+		for (int ju = 0; ju <= M; ju++)
+			for (int j = 0; j < C; j++)
+			{
+				columns[ju][j] = dColumns[ju][j] = vec3(0.0f);
+				for (int i = 0; i < R; i++)
+				{
+					columns[ju][j] += Bu[ju][i] * cps[i * C + j];
+					dColumns[ju][j] += dBu[ju][i] * cps[i * C + j];
+				}
+			}
+
+		gridPos.assign((N + 1) * (M + 1), vec3(0.0f));
+		gridDu.assign((N + 1) * (M + 1), vec3(0.0f));
+		gridDv.assign((N + 1) * (M + 1), vec3(0.0f));
+		for (int iv = 0; iv <= N; iv++)
+			for (int ju = 0; ju <= M; ju++)
+			{
+				int g = iv * (M + 1) + ju;
+				for (int j = 0; j < C; j++)
+				{
+					gridPos[g] += Bv[iv][j] * columns[ju][j];
+					gridDu[g] += Bv[iv][j] * dColumns[ju][j];
+					gridDv[g] += dBv[iv][j] * columns[ju][j];
+				}
+			}
+		GenStrips();
 	}
 
 	mat4 M() { return translate(translation) * rotate(rotAngle, rotAxis) * scale(scaling); }
@@ -209,13 +358,27 @@ public:
 		surfaceShader->setUniform(material.ka, "ka");
 		surfaceShader->setUniform(material.shine, "shine");
 
-		Bind();
-		glEnableVertexAttribArray(0);  // attribute array 0 = POSITION
-		glEnableVertexAttribArray(1);  // attribute array 1 = NORMAL
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, position));
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, normal));
-		for (unsigned int i = 0; i < nStrips; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, i * nVtxPerStrip, nVtxPerStrip);
+		if (hardwareTessellation)
+		{
+			surfaceShader->setUniform(vec2((float)winWidth, (float)winHeight), "viewportSize");
+			surfaceShader->setUniform(pixelsPerSegment, "pixelsPerSegment");
+
+			controlPoints->Bind();
+			glEnableVertexAttribArray(0);  // attribute array 0 = POSITION
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+			glPatchParameteri(GL_PATCH_VERTICES, R * C);
+			glDrawArrays(GL_PATCHES, 0, R * C);
+		}
+		else
+		{
+			Bind();
+			glEnableVertexAttribArray(0);  // attribute array 0 = POSITION
+			glEnableVertexAttribArray(1);  // attribute array 1 = NORMAL
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, position));
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, normal));
+			for (unsigned int i = 0; i < nStrips; i++)
+				glDrawArrays(GL_TRIANGLE_STRIP, i * nVtxPerStrip, nVtxPerStrip);
+		}
 
 		pointShader->Use();
 		pointShader->setUniform(MVP, "MVP");
@@ -230,13 +393,41 @@ public:
 	}
 
 private:
-	float B(int i, int n, float t)
+	// Bernstein polynomials of degree n - 1 at t and their derivatives, raising the degree one at a time
+	template<unsigned n>
+	static void Bernstein(float t, std::array<float, n>& b, std::array<float, n>& d)
 	{
-		float choose = 1;
-		for (int j = 1; j <= i; j++)
-			choose *= (float)(n - (i - j)) / j;
+		b.fill(0.0f);
+		d.fill(0.0f);
+		b[0] = 1.0f;
+		for (int k = 1; k < n; k++)
+		{
+			if (k == n - 1) // b holds degree n - 2
+				for (int i = 0; i < n; i++) d[i] = (n - 1) * ((i > 0 ? b[i - 1] : 0.0f) - b[i]);
+			for (int i = k; i > 0; i--) b[i] = (1 - t) * b[i] + t * b[i - 1];
+			b[0] *= 1 - t;
+		}
+	}
 
-		return choose * powf(t, i) * powf(1 - t, n - i);
+	// strips of the grid points, with the analytic normals
+	void GenStrips()
+	{
+		int N = (int)Bv.size() - 1, M = (int)Bu.size() - 1;
+		auto vertex = [&](int iv, int ju) {
+			int g = iv * (M + 1) + ju;
+			return VertexData{ gridPos[g], normalize(cross(gridDu[g], gridDv[g])) };
+		};
+
+		nVtxPerStrip = (M + 1) * 2;
+		nStrips = N;
+		vtx.clear();
+		for (int i = 0; i < N; i++) {
+			for (int j = 0; j <= M; j++) {
+				vtx.push_back(vertex(i, j));
+				vtx.push_back(vertex(i + 1, j));
+			}
+		}
+		updateGPU();
 	}
 };
 
@@ -249,6 +440,7 @@ class FreeformSurfacesBezier : public glApp
 	BezierSurface<4, 4>* surface;
 
 	GPUProgram* phongShader;
+	GPUProgram* tessShader;
 	GPUProgram* basicShader;
 
 	vec3* draggedVertex = nullptr;
@@ -257,8 +449,8 @@ class FreeformSurfacesBezier : public glApp
 	bool wireframe = false;
 
 public:
-	FreeformSurfacesBezier() : glApp("Freeform Surfaces - Bezier") {}
-	~FreeformSurfacesBezier() { delete camera; delete phongShader; delete basicShader; delete surface; }
+	FreeformSurfacesBezier() : glApp(4, 0, winWidth, winHeight, "Freeform Surfaces - Bezier") {} // tessellation shaders
+	~FreeformSurfacesBezier() { delete camera; delete phongShader; delete tessShader; delete basicShader; delete surface; }
 
 	// Inicializci
 	void onInitialization()
@@ -276,6 +468,9 @@ public:
 		surface = new BezierSurface<4, 4>(vec3(0.0f), material);
 
 		phongShader = new GPUProgram(vertSourcePhong, fragSourcePhong);
+		std::string header = BezierSurface<4, 4>::ShaderHeader();
+		tessShader = new GPUProgram(vertSourcePatch, fragSourcePhong, nullptr,
+			(header + tescSourcePatch).c_str(), (header + teseSourcePatch).c_str());
 		basicShader = new GPUProgram(vertSourceBasic, fragSourceBasic);
 	}
 
@@ -286,13 +481,30 @@ public:
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		glViewport(0, 0, winWidth, winHeight);
 
-		phongShader->Use();
-		phongShader->setUniform(light.La, "La");
-		phongShader->setUniform(light.Le, "Le");
-		phongShader->setUniform(light.wLightPos, "wLiPos");
-		phongShader->setUniform(camera->wEye, "wEye");
+		GPUProgram* surfaceShader = surface->IsHardwareTessellation() ? tessShader : phongShader;
+		surfaceShader->Use();
+		surfaceShader->setUniform(light.La, "La");
+		surfaceShader->setUniform(light.Le, "Le");
+		surfaceShader->setUniform(light.wLightPos, "wLiPos");
+		surfaceShader->setUniform(camera->wEye, "wEye");
 
-		surface->Draw(camera, phongShader, basicShader);
+		surface->Draw(camera, surfaceShader, basicShader);
+	}
+
+	// t: hardware tessellation or CPU mesh, +/-: finer or coarser hardware tessellation
+	void onKeyboard(int key)
+	{
+		if (key == 't')
+		{
+			surface->SetHardwareTessellation(!surface->IsHardwareTessellation());
+			printf("%s\n", surface->IsHardwareTessellation() ? "hardware tessellation" : "CPU mesh");
+		}
+		else if (key == '+' || key == '-')
+		{
+			surface->pixelsPerSegment = clamp(surface->pixelsPerSegment * (key == '+' ? 0.5f : 2.0f), 1.0f, 256.0f);
+			printf("%g pixels per segment\n", surface->pixelsPerSegment);
+		}
+		refreshScreen();
 	}
 
 	void onMousePressed(MouseButton but, int pX, int pY)
@@ -321,6 +533,8 @@ public:
 	}
 	void onMouseReleased(MouseButton but, int pX, int pY)
 	{
+		if (draggedVertex != nullptr && !surface->IsHardwareTessellation())
+			surface->Update(); // drops the rounding errors of the incremental updates
 		draggedVertex = nullptr;
 	}
 	void onMouseMotion(int pX, int pY)
@@ -332,9 +546,7 @@ public:
 		vec4 mouseWorld = inverse(camera->P() * camera->V()) * vec4(mouseNDC, 1.0f);
 		mouseWorld /= mouseWorld.w;
 
-		*draggedVertex = vec3(mouseWorld);
-
-		surface->Update();
+		surface->MoveControlPoint((int)(draggedVertex - &surface->Cps()[0]), vec3(mouseWorld));
 		refreshScreen();
 	}
 
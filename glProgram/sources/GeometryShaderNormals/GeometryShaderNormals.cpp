@@ -199,8 +199,6 @@ struct VertexData
 //---------------------------
 class ParamSurface : public Geometry<VertexData> {
 
-	int nVtxPerStrip, nStrips;
-
 public:
 	float rotAngle;
 	vec3 translation, rotAxis, scaling;
@@ -208,9 +206,7 @@ public:
 	Material material;
 
 	ParamSurface(vec3 position, Material material)
-		: translation(position), rotAxis(1.0f), rotAngle(0.0f), scaling(1.0f), material(material) {
-		nVtxPerStrip = nStrips = 0;
-	}
+		: translation(position), rotAxis(1.0f), rotAngle(0.0f), scaling(1.0f), material(material) { }
 
 	virtual void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z) = 0;
 
@@ -226,15 +222,13 @@ public:
 	}
 
 	void create(int N = tessellationLevel, int M = tessellationLevel) {
-		nVtxPerStrip = (M + 1) * 2;
-		nStrips = N;
 		vtx.clear();
-		for (int i = 0; i < N; i++) {
+		for (int i = 0; i <= N; i++) {
 			for (int j = 0; j <= M; j++) {
 				vtx.push_back(GenVertexData((float)j / M, (float)i / N));
-				vtx.push_back(GenVertexData((float)j / M, (float)(i + 1) / N));
 			}
 		}
+		GridStrips(N, M); // every grid vertex once, the strips index them
 		// Enable the vertex attribute arrays
 		glEnableVertexAttribArray(0);  // attribute array 0 = POSITION
 		glEnableVertexAttribArray(1);  // attribute array 1 = NORMAL
@@ -262,9 +256,7 @@ public:
 		gpuProgram->setUniform(material.ka, "ka");
 		gpuProgram->setUniform(material.shine, "shine");
 
-		Bind();
-		for (unsigned int i = 0; i < nStrips; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, i * nVtxPerStrip, nVtxPerStrip);
+		DrawStrips();
 	}
 };
 
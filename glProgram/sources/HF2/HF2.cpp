@@ -3,6 +3,7 @@
 //=============================================================================================
 #include "framework.h"
 #include <iostream>
+#include <algorithm>
 
 // cscspont rnyal
 const char* vertSource = R"(
@@ -83,14 +84,27 @@ protected:
 	float rotation = 0;
 };
 
-const int nTessVertices = 500;
 class Spline : public Object
 {
 	Geometry<vec2>* controlPoints;
 	std::vector<float> knotValues;
+	Camera2D* camera;				// the tessellation is flat in its pixels
+	CurveTessellator tessellator;
+
+	// Hermite polynomial of a segment in (tau - t0), rebuilt when a control point is added
+	struct Segment
+	{
+		vec2 a0, a1, a2, a3;
+		float t0;
+	};
+	std::vector<Segment> segments;
+
+	// arcLength[k]: length of the curve up to tau = k / (arcLength.size() - 1)
+	static const int nArcSamplesPerSegment = 16;
+	std::vector<float> arcLength;
 
 public:
-	Spline() : Object() { controlPoints = new Geometry<vec2>(); }
+	Spline(Camera2D* camera) : Object(), camera(camera) { controlPoints = new Geometry<vec2>(); }
 	~Spline() { delete controlPoints; }
 
 	void AddControlPoint(vec2 cp)
@@ -98,9 +112,11 @@ public:
 		controlPoints->Vtx().push_back(cp);
 		controlPoints->updateGPU();
 
-		knotValues.push_back(69);
+		knotValues.resize(controlPoints->Vtx().size());
 		for (int i = 0; i < controlPoints->Vtx().size(); i++)
 			knotValues[i] = (float)i / (controlPoints->Vtx().size() - 1);
+		if (controlPoints->Vtx().size() >= 2)
+			UpdateSegments();
 	}
 	void Render(GPUProgram* gpuProgram, Camera2D* camera, vec3 color) override
 	{
@@ -114,11 +130,9 @@ public:
 			return {};
 
 		std::vector<vec2> vertices;
-		for (int i = 0; i <= nTessVertices; ++i)
-		{
-			float t = (float)i / nTessVertices;
-			vertices.push_back(r(t));
-		}
+		mat4 toPixels = ::scale(vec3(winWidth / 2.0f, winHeight / 2.0f, 1.0f)) * camera->P() * camera->V();
+		tessellator.Tessellate([this](float t) { return r(t); }, 0.0f, 1.0f, toPixels, vertices, 4 * (int)segments.size());
+		printf("%d track vertices, %d evaluations\n", tessellator.VertexCount(), tessellator.Evaluations());
 		return vertices;
 	}
 
@@ -161,109 +175,85 @@ public:
 	}
 	vec2 r(float tau) const
 	{
-		int i = GetIndexByTau(tau);
-		const auto& cps = controlPoints->Vtx();
-
-		vec2 v0(0, 0), v1(0, 0);
-		if (i > 0)
-			v0 = (cps[i + 1] - cps[i - 1]) / (knotValues[i + 1] - knotValues[i - 1]);
-		if (i < cps.size() - 2)
-			v1 = (cps[i + 2] - cps[i]) / (knotValues[i + 2] - knotValues[i]);
-
-		return Hermite(
-			cps[i],
-			v0,
-			knotValues[i],
-
-			cps[i + 1],
-			v1,
-			knotValues[i + 1],
-
-			tau
-		);
+		const Segment& seg = GetSegment(tau);
+		float t = tau - seg.t0;
+		return ((seg.a3 * t + seg.a2) * t + seg.a1) * t + seg.a0;
 	}
 	vec2 r_prime(float tau) const
 	{
-		int i = GetIndexByTau(tau);
-		const auto& cps = controlPoints->Vtx();
-
-		vec2 v0(0, 0), v1(0, 0);
-		if (i > 0)
-			v0 = (cps[i + 1] - cps[i - 1]) / (knotValues[i + 1] - knotValues[i - 1]);
-		if (i < cps.size() - 2)
-			v1 = (cps[i + 2] - cps[i]) / (knotValues[i + 2] - knotValues[i]);
-
-		return HermiteDerivative(
-			cps[i],
-			v0,
-			knotValues[i],
-
-			cps[i + 1],
-			v1,
-			knotValues[i + 1],
-
-			tau
-		);
+		const Segment& seg = GetSegment(tau);
+		float t = tau - seg.t0;
+		return (3.0f * seg.a3 * t + 2.0f * seg.a2) * t + seg.a1;
 	}
 	vec2 r_prime_prime(float tau) const
 	{
-		int i = GetIndexByTau(tau);
-		const auto& cps = controlPoints->Vtx();
-
-		vec2 v0(0, 0), v1(0, 0);
-		if (i > 0)
-			v0 = (cps[i + 1] - cps[i - 1]) / (knotValues[i + 1] - knotValues[i - 1]);
-		if (i < cps.size() - 2)
-			v1 = (cps[i + 2] - cps[i]) / (knotValues[i + 2] - knotValues[i]);
-
-		return HermiteSecondDerivative(
-			cps[i],
-			v0,
-			knotValues[i],
-
-			cps[i + 1],
-			v1,
-			knotValues[i + 1],
-
-			tau
-		);
+		const Segment& seg = GetSegment(tau);
+		return 6.0f * seg.a3 * (tau - seg.t0) + 2.0f * seg.a2;
 	}
-	vec2 Hermite(const vec2& p0, const vec2& v0, float t0, const vec2& p1, const vec2& v1, float t1, float t) const
-	{
-		float dt = t1 - t0;
-		vec2 a0 = p0, a1 = v0;
-		vec2 a2 = 3.0f * (p1 - p0) / dt / dt - (v1 + 2.0f * v0) / dt;
-		vec2 a3 = 2.0f * (p0 - p1) / dt / dt / dt + (v1 + v0) / dt / dt;
 
-		dt = t - t0;
-		return ((a3 * dt + a2) * dt + a1) * dt + a0;
-	}
-	vec2 HermiteDerivative(const vec2& p0, const vec2& v0, float t0, const vec2& p1, const vec2& v1, float t1, float t) const
+	float Length() const { return arcLength.empty() ? 0.0f : arcLength.back(); }
+	// O(1), the table is uniform in tau
+	float DistanceAtTau(float tau) const
 	{
-		float dt = t1 - t0;
-		vec2 a1 = v0;
-		vec2 a2 = 3.0f * (p1 - p0) / powf(dt, 2) - (v1 + 2.0f * v0) / dt;
-		vec2 a3 = 2.0f * (p0 - p1) / powf(dt, 3) + (v1 + v0) / powf(dt, 2);
-
-		dt = t - t0;
-		return 3.0f * a3 * powf(dt, 2) + 2.0f * a2 * dt + a1;
+		if (arcLength.size() < 2) return 0.0f;
+		float x = clamp(tau, 0.0f, 1.0f) * (arcLength.size() - 1);
+		int k = min((int)x, (int)arcLength.size() - 2);
+		return mix(arcLength[k], arcLength[k + 1], x - k);
 	}
-	vec2 HermiteSecondDerivative(const vec2& p0, const vec2& v0, float t0, const vec2& p1, const vec2& v1, float t1, float t) const
+	// O(log n), binary search in the table
+	float TauAtDistance(float s) const
 	{
-		float dt = t1 - t0;
-		vec2 a2 = 3.0f * (p1 - p0) / dt / dt - (v1 + 2.0f * v0) / dt;
-		vec2 a3 = 2.0f * (p0 - p1) / dt / dt / dt + (v1 + v0) / dt / dt;
+		if (arcLength.size() < 2) return 0.0f;
+		int k = (int)(std::upper_bound(arcLength.begin(), arcLength.end(), s) - arcLength.begin()) - 1;
+		k = clamp(k, 0, (int)arcLength.size() - 2);
+		float segmentLength = arcLength[k + 1] - arcLength[k];
+		float frac = segmentLength > 0.0f ? clamp((s - arcLength[k]) / segmentLength, 0.0f, 1.0f) : 0.0f;
+		return (k + frac) / (arcLength.size() - 1);
+	}
 
-		return 6.0f * a3 * (t - t0) + 2.0f * a2;
+private:
+	// the knots are uniform, so the segment of tau is a multiplication away
+	const Segment& GetSegment(float tau) const
+	{
+		int i = (int)(tau * segments.size());
+		return segments[clamp(i, 0, (int)segments.size() - 1)];
 	}
-	int GetIndexByTau(float tau) const
+
+	void UpdateSegments()
 	{
 		const auto& cps = controlPoints->Vtx();
-		for (int i = 0; i < cps.size() - 1; i++)
-			if (knotValues[i] <= tau && tau <= knotValues[i + 1])
-				return i;
-	
-		return -1;
+		segments.resize(cps.size() - 1);
+		for (int i = 0; i < segments.size(); i++)
+		{
+			vec2 v0(0, 0), v1(0, 0);
+			if (i > 0)
+				v0 = (cps[i + 1] - cps[i - 1]) / (knotValues[i + 1] - knotValues[i - 1]);
+			if (i < cps.size() - 2)
+				v1 = (cps[i + 2] - cps[i]) / (knotValues[i + 2] - knotValues[i]);
+
+			vec2 p0 = cps[i], p1 = cps[i + 1];
+			float dt = knotValues[i + 1] - knotValues[i];
+			segments[i] = {
+				p0,
+				v0,
+				3.0f * (p1 - p0) / dt / dt - (v1 + 2.0f * v0) / dt,
+				2.0f * (p0 - p1) / dt / dt / dt + (v1 + v0) / dt / dt,
+				knotValues[i]
+			};
+		}
+
+		// |r'| integrated over every step by 3 point Gauss-Legendre quadrature
+		const float nodes[3] = { -sqrtf(0.6f), 0.0f, sqrtf(0.6f) }, weights[3] = { 5.0f / 9.0f, 8.0f / 9.0f, 5.0f / 9.0f };
+		int nSteps = (int)segments.size() * nArcSamplesPerSegment;
+		arcLength.resize(nSteps + 1);
+		arcLength[0] = 0.0f;
+		for (int k = 0; k < nSteps; k++)
+		{
+			float halfStep = 0.5f / nSteps, center = (k + 0.5f) / nSteps, length = 0.0f;
+			for (int q = 0; q < 3; q++)
+				length += weights[q] * glm::length(r_prime(center + nodes[q] * halfStep));
+			arcLength[k + 1] = arcLength[k] + length * halfStep;
+		}
 	}
 };
 
@@ -274,19 +264,25 @@ class Gondola : public Object
 	} state = State::IDLE;
 
 	float tau;
+	float distance;	// along the track, the gondola moves by arc length
 	const Spline& spline;
 	const float radius = 1.0f;
 
+	// ranges of the index buffer, built once with the vertices
+	int fillFirst, fillCount, outlineFirst, outlineCount, spokesFirst, spokesCount;
+
 public:
 	Gondola(const Spline& spline)
-		: Object(), state(State::IDLE), tau(0.0f), spline(spline)
+		: Object(), state(State::IDLE), tau(0.0f), distance(0.0f), spline(spline)
 	{
 		scale = vec2{ radius, radius };
 		Update();
 	}
 	void Start()
 	{
+		if (spline.Length() == 0.0f) return; // no track with fewer than 2 control points
 		tau = 0.01f;
+		distance = spline.DistanceAtTau(tau);
 		rotation = 0.0f;
 		state = State::MOVING;
 	}
@@ -309,12 +305,13 @@ public:
 			return false;
 		}*/
 
-		tau += spline.dtau(tau, dt);
-		if (tau > 1)
+		distance += spline.v(tau) * dt;
+		if (distance > spline.Length())
 		{
 			Start();
 			return false;
 		}
+		tau = spline.TauAtDistance(distance);
 		prevPos = position;
 
 		return true;
@@ -330,31 +327,17 @@ public:
 		gpuProgram->setUniform(MVP, "MVP");
 
 		// draw blue circle
-		Draw(gpuProgram, GL_TRIANGLE_FAN, color);
+		Draw(gpuProgram, GL_TRIANGLE_FAN, color, fillFirst, fillCount);
 
 		// draw white border
-		std::vector<vec2> borderVtx(vtx.begin() + 1, vtx.end());
-		std::swap(vtx, borderVtx);
-		updateGPU();
-		Draw(gpuProgram, GL_LINE_LOOP, { 1.0f, 1.0f, 1.0f });
-		std::swap(vtx, borderVtx);
-		updateGPU();
+		Draw(gpuProgram, GL_LINE_LOOP, { 1.0f, 1.0f, 1.0f }, outlineFirst, outlineCount);
 
 		// draw diagonals (from center to circumference)
-		std::vector<vec2> vtxDiagonals;
-		for (int i = 1; i < vtx.size(); i += 6)
-		{
-			vtxDiagonals.push_back(vtx[0]); // Center (0, 0)
-			vtxDiagonals.push_back(vtx[i]); // Circumference point
-		}
-		std::swap(vtx, vtxDiagonals);
-		updateGPU();
-		Draw(gpuProgram, GL_LINES, { 1.0f, 1.0f, 1.0f });
-		std::swap(vtx, vtxDiagonals);
-		updateGPU();
+		Draw(gpuProgram, GL_LINES, { 1.0f, 1.0f, 1.0f }, spokesFirst, spokesCount);
 	}
 
 private:
+	// the indices of the three parts go to idx at the same time, Update uploads both once
 	std::vector<vec2> GenVertexData() override
 	{
 		static const int resolution = 36;
@@ -365,8 +348,26 @@ private:
 		for (float angle = 0.0f; angle < 2 * M_PI + dangle * 0.5f; angle += dangle)
 			vertices.push_back(vec2{ cosf(angle), sinf(angle) });
 
-		return vertices;
+		idx.clear();
+		fillFirst = (int)idx.size();
+		for (int i = 0; i < vertices.size(); i++)
+			idx.push_back(i);
+		fillCount = (int)idx.size() - fillFirst;
+
+		outlineFirst = (int)idx.size();
+		for (int i = 1; i < vertices.size(); i++)
+			idx.push_back(i);
+		outlineCount = (int)idx.size() - outlineFirst;
 
+		spokesFirst = (int)idx.size();
+		for (int i = 1; i < vertices.size(); i += 6)
+		{
+			idx.push_back(0); // Center (0, 0)
+			idx.push_back(i); // Circumference point
+		}
+		spokesCount = (int)idx.size() - spokesFirst;
+
+		return vertices;
 	}
 };
 
@@ -385,9 +386,9 @@ public:
 		glPointSize(10);
 		glLineWidth(3);
 
-		spline = new Spline();
-		gondola = new Gondola(*spline);
 		camera = new Camera2D({ 0, 0 }, { 20, 20 });
+		spline = new Spline(camera);
+		gondola = new Gondola(*spline);
 		gpuProgram = new GPUProgram(vertSource, fragSource);
 	}
 	void onDisplay() override
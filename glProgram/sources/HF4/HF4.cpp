@@ -42,7 +42,7 @@ class Texture2D
 	unsigned int textureId = 0;
 
 public:
-	Texture2D(int width, int height, vec3* data)
+	Texture2D(PixelBuffer& image)
 	{
 		// setup VAO
 		glGenVertexArrays(1, &vao);
@@ -66,16 +66,14 @@ public:
 		// setup texture
 		glGenTextures(1, &textureId);
 		glBindTexture(GL_TEXTURE_2D, textureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0,
-			GL_RGB, GL_FLOAT, data);
+		image.Upload(true);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	}
-	void UpdateData(int width, int height, vec3* data)
+	void UpdateData(PixelBuffer& image)
 	{
 		glBindTexture(GL_TEXTURE_2D, textureId);
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
-			GL_RGB, GL_FLOAT, data);
+		image.Upload();
 	}
 	void Bind(int textureUnit)
 	{
@@ -307,7 +305,7 @@ class Scene
 	vec3 La;			// ambient light
 	float Ne = 0.001f;  // epsilon
 
-	vec3 image[winWidth * winHeight];
+	PixelBuffer image = PixelBuffer(winWidth, winHeight, PIXEL_RGB10A2);
 	Texture2D* texture = nullptr;
 
 	std::vector<Light*> lights;
@@ -322,7 +320,7 @@ public:
 		camera = new Camera({ 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { winWidth, winHeight }, 45.0f);
 		updateCameraPosition();
 
-		texture = new Texture2D(winWidth, winHeight, image);
+		texture = new Texture2D(image);
 
 		Material* checkerBoardMaterial1 = new Material{ vec3(0.0f), vec3(0.0f), vec3(0.9f, 0.9f, 0.9f), vec3(0.3f, 0.3f, 0.3f), vec3(0.0f), 0.0f, false, false, true };
 		Material* checkerBoardMaterial2 = new Material{ vec3(0.0f), vec3(0.0f), vec3(0.0f, 0.3f, 0.9f), vec3(0.0f, 0.1f, 0.3f), vec3(0.0f), 0.0f, false, false, true };
@@ -357,10 +355,10 @@ public:
 			{
 				Ray ray = camera->getRay(j, i);
 				vec3 color = trace(ray, objects, maxDepth);
-				image[i * winWidth + j] = color;
+				image.Set(j, i, color);
 			}
 		}
-		texture->UpdateData(winWidth, winHeight, image);
+		texture->UpdateData(image);
 	}
 	void render(GPUProgram* gpuProgram)
 	{
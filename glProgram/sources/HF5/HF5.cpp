@@ -273,10 +273,8 @@ struct VertexData
 
 class ParamSurface : public Geometry<VertexData> 
 {
-	unsigned int nVtxPerStrip, nStrips;
-
 public:
-	ParamSurface() { nVtxPerStrip = nStrips = 0; }
+	ParamSurface() { }
 
 	virtual void eval(Dnum2& U, Dnum2& V, Dnum2& X, Dnum2& Y, Dnum2& Z) = 0;
 
@@ -295,17 +293,16 @@ public:
 
 	void create(int N = defaultN, int M = defaultM) 
 	{
-		nVtxPerStrip = (M + 1) * 2;
-		nStrips = N;
-		for (int i = 0; i < N; i++)
+		vtx.clear();
+		for (int i = 0; i <= N; i++)
 		{
 			for (int j = 0; j <= M; j++)
 			{
 				vtx.push_back(GenVertexData((float)j / M, (float)i / N));
-				vtx.push_back(GenVertexData((float)j / M, (float)(i + 1) / N));
 			}
 		}
-		glBufferData(GL_ARRAY_BUFFER, nVtxPerStrip * nStrips * sizeof(VertexData), &vtx[0], GL_STATIC_DRAW);
+		GridStrips(N, M); // every grid vertex once, the strips index them
+		updateGPU();
 		// Enable the vertex attribute arrays
 		glEnableVertexAttribArray(0);  // attribute array 0 = POSITION
 		glEnableVertexAttribArray(1);  // attribute array 1 = NORMAL
@@ -318,9 +315,7 @@ public:
 
 	void Draw()
 	{
-		Bind();
-		for (unsigned int i = 0; i < nStrips; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, i * nVtxPerStrip, nVtxPerStrip);
+		DrawStrips();
 	}
 };
 
@@ -407,11 +402,15 @@ public:
 		for (const auto& vertex : vtx)
 			worldVertices.push_back(Vertex2World(M, vertex.position));
 
-		for (size_t i = 0; i < worldVertices.size() - 2; i++)
+		// the triangles of the strips, none across a restart
+		const auto& idx = geometry->Idx();
+		for (size_t i = 0; i + 2 < idx.size(); i++)
 		{
-			vertices.push_back(worldVertices[i]);
-			vertices.push_back(worldVertices[i + 1]);
-			vertices.push_back(worldVertices[i + 2]);
+			if (idx[i] == ParamSurface::restartIndex || idx[i + 1] == ParamSurface::restartIndex || idx[i + 2] == ParamSurface::restartIndex)
+				continue;
+			vertices.push_back(worldVertices[idx[i]]);
+			vertices.push_back(worldVertices[idx[i + 1]]);
+			vertices.push_back(worldVertices[idx[i + 2]]);
 		}
 
 		return vertices;
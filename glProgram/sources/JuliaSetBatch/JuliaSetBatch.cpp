@@ -0,0 +1,218 @@
+//=============================================================================================
+// Julia Set - headless batch renderer for parameter sweeps
+//=============================================================================================
+// Renders the same image as the JuliaSet demo for every c along a path, on the CPU, without
+// an OpenGL context. Frames are rendered in parallel and written in order through a bounded
+// queue, so memory use does not depend on the length of the sequence.
+//
+// Usage: JuliaSetBatch [-o dir|-] [-n frames] [-t threads] [-q queue] [-c x,y]...
+//   -o  output directory for frame_00000.png, ... or '-' for raw RGB24 frames on stdout
+//       (e.g. | ffmpeg -f rawvideo -pixel_format rgb24 -video_size 600x600 -i - out.mp4)
+//   -c  key points of the path through c-space (polyline, traversed at constant speed);
+//       without key points c runs around the circle |c| = 0.7885
+#define _USE_MATH_DEFINES		// M_PI
+#define _CRT_SECURE_NO_WARNINGS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <glm/glm.hpp>
+#include "lodepng.h"
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+using namespace glm;
+
+const int winWidth = 600, winHeight = 600;
+const int nIteration = 1000;
+
+// c(t), t in [0, 1]
+class CPath
+{
+	std::vector<vec2> keys;
+	std::vector<float> lengths; // cumulated arc length at each key
+public:
+	void AddKey(vec2 c)
+	{
+		lengths.push_back(keys.empty() ? 0.0f : lengths.back() + length(c - keys.back()));
+		keys.push_back(c);
+	}
+
+	vec2 c(float t) const
+	{
+		if (keys.empty())
+			return 0.7885f * vec2(cosf(2.0f * (float)M_PI * t), sinf(2.0f * (float)M_PI * t));
+		if (keys.size() == 1 || lengths.back() == 0.0f)
+			return keys[0];
+
+		float s = t * lengths.back();
+		size_t i = 1;
+		while (i < keys.size() - 1 && lengths[i] < s) i++;
+		float segLength = lengths[i] - lengths[i - 1];
+		float w = segLength > 0.0f ? (s - lengths[i - 1]) / segLength : 0.0f;
+		return mix(keys[i - 1], keys[i], w);
+	}
+};
+
+// Reorder buffer between the render threads and the writer: frame i lives in slot i % capacity,
+// and a frame may only be started once it fits into the window after the next frame to write.
+class FrameQueue
+{
+	std::vector<std::vector<unsigned char>> slots;
+	std::vector<bool> ready;
+	int nextToWrite = 0;
+	std::mutex mutex;
+	std::condition_variable cv;
+public:
+	FrameQueue(int capacity, size_t frameBytes) : slots(capacity, std::vector<unsigned char>(frameBytes)), ready(capacity, false) {}
+
+	std::vector<unsigned char>& Acquire(int frame)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [&] { return frame < nextToWrite + (int)slots.size(); });
+		return slots[frame % slots.size()];
+	}
+
+	void Publish(int frame)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready[frame % slots.size()] = true;
+		cv.notify_all();
+	}
+
+	std::vector<unsigned char>& Front()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cv.wait(lock, [&] { return (bool)ready[nextToWrite % slots.size()]; });
+		return slots[nextToWrite % slots.size()];
+	}
+
+	void Pop()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		ready[nextToWrite % slots.size()] = false;
+		nextToWrite++;
+		cv.notify_all();
+	}
+};
+
+// same mapping and coloring as the fragment shader of the JuliaSet demo
+void RenderFrame(vec2 c, vec2 cameraCenter, vec2 cameraSize, unsigned char* rgb)
+{
+	const unsigned char inside[3] = { 25, 255, 25 }, outside[3] = { 25, 25, 25 };
+	for (int pY = 0; pY < winHeight; pY++)
+	{
+		float y = (1.0f - (pY + 0.5f) * 2.0f / winHeight) * cameraSize.y / 2 + cameraCenter.y;
+		for (int pX = 0; pX < winWidth; pX++)
+		{
+			vec2 z(((pX + 0.5f) * 2.0f / winWidth - 1.0f) * cameraSize.x / 2 + cameraCenter.x, y);
+			int i;
+			for (i = 0; i < nIteration; i++)
+			{
+				if (dot(z, z) >= 100.0f) break; // |c| < 2, so it escapes from here on
+				z = vec2(z.x * z.x - z.y * z.y, 2 * z.x * z.y) + c;
+			}
+			memcpy(rgb + 3 * (pY * winWidth + pX), dot(z, z) < 100.0f ? inside : outside, 3);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string outDir = ".";
+	int nFrames = 600;
+	int nThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	int queueCapacity = 0;
+	CPath path;
+
+	for (int a = 1; a < argc; a++)
+	{
+		bool hasValue = a + 1 < argc;
+		if (!strcmp(argv[a], "-o") && hasValue) outDir = argv[++a];
+		else if (!strcmp(argv[a], "-n") && hasValue) nFrames = atoi(argv[++a]);
+		else if (!strcmp(argv[a], "-t") && hasValue) nThreads = std::max(1, atoi(argv[++a]));
+		else if (!strcmp(argv[a], "-q") && hasValue) queueCapacity = atoi(argv[++a]);
+		else if (!strcmp(argv[a], "-c") && hasValue)
+		{
+			vec2 c;
+			if (sscanf(argv[++a], "%f,%f", &c.x, &c.y) != 2)
+			{
+				fprintf(stderr, "Invalid key point: %s\n", argv[a]);
+				return EXIT_FAILURE;
+			}
+			path.AddKey(c);
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [-o dir|-] [-n frames] [-t threads] [-q queue] [-c x,y]...\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (queueCapacity <= 0) queueCapacity = 2 * nThreads;
+
+	bool rawOutput = (outDir == "-");
+#ifdef _WIN32
+	if (rawOutput) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	const vec2 cameraCenter(0.0f), cameraSize(2.0f);
+	const size_t frameBytes = 3 * winWidth * winHeight;
+	FrameQueue queue(queueCapacity, frameBytes);
+	std::atomic<int> nextFrame(0);
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (int w = 0; w < nThreads; w++)
+	{
+		workers.emplace_back([&] {
+			for (int frame = nextFrame++; frame < nFrames; frame = nextFrame++)
+			{
+				float t = nFrames > 1 ? (float)frame / (nFrames - 1) : 0.0f;
+				RenderFrame(path.c(t), cameraCenter, cameraSize, queue.Acquire(frame).data());
+				queue.Publish(frame);
+			}
+		});
+	}
+
+	// streaming encoder: frames leave the queue strictly in order
+	bool ok = true;
+	for (int frame = 0; frame < nFrames; frame++)
+	{
+		std::vector<unsigned char>& rgb = queue.Front();
+		if (ok && rawOutput)
+			ok = fwrite(rgb.data(), 1, frameBytes, stdout) == frameBytes;
+		else if (ok)
+		{
+			char fileName[32];
+			snprintf(fileName, sizeof(fileName), "/frame_%05d.png", frame);
+			unsigned error = lodepng_encode24_file((outDir + fileName).c_str(), rgb.data(), winWidth, winHeight);
+			if (error)
+			{
+				fprintf(stderr, "Error while writing %s%s: %s\n", outDir.c_str(), fileName, lodepng_error_text(error));
+				ok = false;
+			}
+		}
+		queue.Pop();
+
+		if ((frame + 1) % 100 == 0 || frame + 1 == nFrames)
+		{
+			float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+			fprintf(stderr, "%d/%d frames, %.2f fps\n", frame + 1, nFrames, (frame + 1) / seconds);
+		}
+	}
+	for (std::thread& worker : workers) worker.join();
+	if (rawOutput) fflush(stdout);
+
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
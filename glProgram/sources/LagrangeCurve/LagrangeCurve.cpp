@@ -2,6 +2,8 @@
 // Lagrange Curve
 //=============================================================================================
 #include "framework.h"
+#include <chrono>
+#include <random>
 
 // cscspont rnyal
 const char* vertSource = R"(
@@ -30,20 +32,88 @@ const char* fragSource = R"(
 	}
 )";
 
+// curve vertex shader: the barycentric formula from the control points, weights and knots in a texture buffer,
+// gl_VertexID is the sample
+const char* curveVertSource = R"(
+	#version 330
+    precision highp float;
+
+	uniform samplerBuffer controlPoints;	// xy: point, z: weight, w: knot
+	uniform int nControlPoints, nSamples;
+
+	void main()
+	{
+		float t = float(gl_VertexID) / float(nSamples - 1);
+		vec2 numerator = vec2(0, 0);
+		float denominator = 0.0;
+		for (int j = 0; j < nControlPoints; j++)
+		{
+			vec4 cp = texelFetch(controlPoints, j);
+			float d = t - cp.w;
+			if (d == 0.0) { gl_Position = vec4(cp.xy, 0, 1); return; }
+			float c = cp.z / d;
+			numerator += cp.xy * c;
+			denominator += c;
+		}
+		gl_Position = vec4(numerator / denominator, 0, 1);
+	}
+)";
+
 const int winWidth = 600, winHeight = 600;
 
+// the original evaluation with the full product for every basis function at every sample, O(n^2),
+// kept as reference for the benchmark
+vec2 LagrangeProduct(const std::vector<vec2>& cps, const std::vector<double>& knots, float t)
+{
+	vec2 rt(0, 0);
+	for (int i = 0; i < cps.size(); i++)
+	{
+		float Li = 1.0f;
+		for (int j = 0; j < cps.size(); j++)
+			if (j != i) Li *= (t - (float)knots[j]) / ((float)knots[i] - (float)knots[j]);
+		rt += cps[i] * Li;
+	}
+	return rt;
+}
+
 const int nTessVertices = 500;
+
+// adaptive: screen space adaptive tessellation, uniform: nTessVertices + 1 samples on the CPU,
+// gpu: only the control points are uploaded, the vertex shader evaluates the samples
+enum Tessellation { TESSELLATION_ADAPTIVE, TESSELLATION_UNIFORM, TESSELLATION_GPU };
+const char* tessellationNames[] = { "adaptive", "uniform", "GPU" };
+
+// Second (true) barycentric form: r(t) = sum w_j p_j / (t - t_j) / sum w_j / (t - t_j) with the weights
+// w_j = 1 / prod (t_j - t_k). The weights depend only on the knots, and a new knot updates them in O(n).
+// The two sums of every sample are kept, so moving a control point only adds its change to the numerators.
 class LagrangeCurve
 {
 	Geometry<vec2>* controlPoints;
-	std::vector<float> knotValues;
+	std::vector<double> knotValues;
+	std::vector<double> weights;	// up to a common factor, which cancels
 	Geometry<vec2>* curvePoints;
 
+	std::vector<dvec2> numerators;	// per sample
+	std::vector<double> denominators;
+	std::vector<int> onKnot;		// the knot a sample falls on, or -1
+
 	vec2* selectedPoint = nullptr;
+	Tessellation tessellation = TESSELLATION_ADAPTIVE;
+	CurveTessellator tessellator;
+
+	TextureBuffer* gpuControlPoints;
+	std::vector<vec4> gpuData;
+	unsigned int emptyVao;	// the GPU samples have no attributes
+	int nGpuSamples = nTessVertices + 1;
 
 public:
-	LagrangeCurve() { controlPoints = new Geometry<vec2>(); curvePoints = new Geometry<vec2>(); }
-	~LagrangeCurve() { delete controlPoints; delete curvePoints; }
+	LagrangeCurve()
+	{
+		controlPoints = new Geometry<vec2>(); curvePoints = new Geometry<vec2>();
+		gpuControlPoints = new TextureBuffer();
+		glGenVertexArrays(1, &emptyVao);
+	}
+	~LagrangeCurve() { delete controlPoints; delete curvePoints; delete gpuControlPoints; glDeleteVertexArrays(1, &emptyVao); }
 
 	void AddControlPoint(vec2 cp)
 	{
@@ -51,9 +121,21 @@ public:
 		controlPoints->updateGPU();
 		Recalculate();
 	}
-	void Render(GPUProgram* gpuProgram)
+	void Render(GPUProgram* gpuProgram, GPUProgram* curveProgram)
 	{
-		if (controlPoints->Vtx().size() >= 2)
+		if (controlPoints->Vtx().size() >= 2 && tessellation == TESSELLATION_GPU)
+		{
+			curveProgram->Use();
+			gpuControlPoints->Bind(0);
+			curveProgram->setUniform(0, "controlPoints");
+			curveProgram->setUniform((int)controlPoints->Vtx().size(), "nControlPoints");
+			curveProgram->setUniform(nGpuSamples, "nSamples");
+			curveProgram->setUniform(vec3(1.0f, 1.0f, 0.0f), "color");
+			glBindVertexArray(emptyVao);
+			glDrawArrays(GL_LINE_STRIP, 0, nGpuSamples);
+			gpuProgram->Use();
+		}
+		else if (controlPoints->Vtx().size() >= 2)
 			curvePoints->Draw(gpuProgram, GL_LINE_STRIP, { 1.0f, 1.0f, 0.0f });
 
 		if (controlPoints->Vtx().size() == 0)
@@ -90,67 +172,203 @@ public:
 	{
 		if (selectedPoint)
 		{
-			*selectedPoint = p;
-			controlPoints->updateGPU();
-			Recalculate();
+			MoveControlPoint((int)(selectedPoint - &controlPoints->Vtx()[0]), p);
 			return true;
 		}
 		return false;
 	}
 
+	Tessellation GetTessellation() const { return tessellation; }
+	int SetTessellation(Tessellation _tessellation) // returns the new vertex count
+	{
+		tessellation = _tessellation;
+		Retessellate();
+		return tessellation == TESSELLATION_GPU ? nGpuSamples : (int)curvePoints->Vtx().size();
+	}
+	// GPU samples, no CPU work
+	int ScaleGpuSamples(float factor)
+	{
+		nGpuSamples = clamp((int)(nGpuSamples * factor), 2, 1 << 20);
+		return nGpuSamples;
+	}
+
+	const std::vector<vec2>& ControlPoints() { return controlPoints->Vtx(); }
+	const std::vector<double>& Knots() { return knotValues; }
+	const std::vector<vec2>& CurvePoints() { return curvePoints->Vtx(); }
+
+	// O(nTessVertices) with uniform samples, a single texel with GPU samples
+	void MoveControlPoint(int k, vec2 p)
+	{
+		auto& cps = controlPoints->Vtx();
+		dvec2 delta = dvec2(p) - dvec2(cps[k]);
+		cps[k] = p;
+		controlPoints->updateGPU();
+		if (tessellation == TESSELLATION_GPU)
+		{
+			gpuData[k] = vec4(p, (float)weights[k], (float)knotValues[k]);
+			gpuControlPoints->updateGPU(gpuData);
+			return;
+		}
+		if (tessellation == TESSELLATION_ADAPTIVE)
+		{
+			Retessellate();
+			return;
+		}
+
+		auto& vertices = curvePoints->Vtx();
+		for (int s = 0; s <= nTessVertices; s++)
+		{
+			if (onKnot[s] >= 0)
+			{
+				if (onKnot[s] == k) vertices[s] = p;
+				continue;
+			}
+			double t = (double)s / nTessVertices;
+			numerators[s] += delta * (weights[k] / (t - knotValues[k]));
+			vertices[s] = vec2(numerators[s] / denominators[s]);
+		}
+		if (vertices.size() >= 2)
+			curvePoints->updateGPU();
+	}
+
 private:
+	// log |w_j| and the sign of w_j from the product, as it under- or overflows at high degrees
+	double LogWeight(int j, int& sign)
+	{
+		double logW = 0.0;
+		sign = 1;
+		for (int k = 0; k < knotValues.size(); k++)
+			if (k != j)
+			{
+				double d = knotValues[j] - knotValues[k];
+				logW -= log(fabs(d));
+				if (d < 0.0) sign = -sign;
+			}
+		return logW;
+	}
+
+	// the knots stay uniform in [0, 1], so the old ones shrink towards 0 with a common factor, which only
+	// scales the weights; the new knot divides the old weights by (t_j - t_new), and its own weight is
+	// scaled to them by its ratio to w_0, O(n)
+	void AddKnot()
+	{
+		int n = (int)controlPoints->Vtx().size();
+		knotValues.resize(n);
+		for (int i = 0; i < n; i++)
+			knotValues[i] = n > 1 ? (double)i / (n - 1) : 0.0;
+		if (n == 1)
+		{
+			weights.assign(1, 1.0);
+			return;
+		}
+
+		for (int j = 0; j < n - 1; j++)
+			weights[j] /= knotValues[j] - knotValues[n - 1];
+		int sign0, signNew;
+		double log0 = LogWeight(0, sign0), logNew = LogWeight(n - 1, signNew);
+		weights.push_back(weights[0] * sign0 * signNew * exp(logNew - log0));
+
+		double largest = 0.0;
+		for (double w : weights) largest = max(largest, fabs(w));
+		for (double& w : weights) w /= largest; // against overflow after many points
+	}
+
 	void Recalculate()
 	{
-		knotValues.push_back(69);
-		for (int i = 0; i < controlPoints->Vtx().size(); i++)
-			knotValues[i] = (float)i / (controlPoints->Vtx().size() - 1);
+		AddKnot();
+		Retessellate();
+		if (tessellation == TESSELLATION_ADAPTIVE)
+			printf("%d curve vertices, %d evaluations\n", tessellator.VertexCount(), tessellator.Evaluations());
+	}
 
+	void Retessellate()
+	{
+		if (tessellation == TESSELLATION_GPU)
+		{
+			UploadControlPoints();
+			return;
+		}
 		curvePoints->Vtx() = GenerateVertices();
 		if (curvePoints->Vtx().size() >= 2)
 			curvePoints->updateGPU();
 	}
 
-	std::vector<vec2> GenerateVertices()
+	// the weights are normalized to at most 1, so the float copy only loses the smallest ones at high degrees
+	void UploadControlPoints()
+	{
+		const auto& cps = controlPoints->Vtx();
+		gpuData.resize(cps.size());
+		for (int j = 0; j < cps.size(); j++) gpuData[j] = vec4(cps[j], (float)weights[j], (float)knotValues[j]);
+		gpuControlPoints->updateGPU(gpuData);
+	}
+
+	// the barycentric formula at any t, O(n)
+	vec2 r(double t)
 	{
-		std::vector<vec2> vertices;
-		for (int i = 0; i <= nTessVertices; ++i)
+		const auto& cps = controlPoints->Vtx();
+		dvec2 numerator(0, 0);
+		double denominator = 0.0;
+		for (int j = 0; j < cps.size(); j++)
 		{
-			float t = (float)i / nTessVertices;
-			vertices.push_back(r(t));
+			double d = t - knotValues[j];
+			if (d == 0.0) return cps[j];
+			double c = weights[j] / d;
+			numerator += dvec2(cps[j]) * c;
+			denominator += c;
 		}
-		return vertices;
+		return vec2(numerator / denominator);
 	}
-	vec2 r(float t)
+
+	// O(n) per sample
+	std::vector<vec2> GenerateVertices()
 	{
-		vec2 rt(0, 0);
 		const auto& cps = controlPoints->Vtx();
-		for (int i = 0; i < cps.size(); i++)
-			rt += cps[i] * L(i, t);
+		if (cps.empty())
+			return {};
+		if (tessellation == TESSELLATION_ADAPTIVE)
+		{
+			std::vector<vec2> vertices;
+			if (cps.size() >= 2)
+				tessellator.Tessellate([&](float t) { return r(t); }, 0.0f, 1.0f, scale(vec3(winWidth / 2.0f, winHeight / 2.0f, 1.0f)), vertices);
+			return vertices;
+		}
 
-		return rt;
-	}
-	float L(int i, float t)
-	{
-		float Li = 1.0f;
-		for (int j = 0; j < controlPoints->Vtx().size(); j++)
-			if (j != i) Li *= (t - knotValues[j]) / (knotValues[i] - knotValues[j]);
-		return Li;
+		std::vector<vec2> vertices(nTessVertices + 1);
+		numerators.assign(nTessVertices + 1, dvec2(0, 0));
+		denominators.assign(nTessVertices + 1, 0.0);
+		onKnot.assign(nTessVertices + 1, -1);
+		for (int s = 0; s <= nTessVertices; s++)
+		{
+			double t = (double)s / nTessVertices;
+			for (int j = 0; j < cps.size(); j++)
+			{
+				double d = t - knotValues[j];
+				if (d == 0.0) { onKnot[s] = j; break; }
+				double c = weights[j] / d;
+				numerators[s] += dvec2(cps[j]) * c;
+				denominators[s] += c;
+			}
+			vertices[s] = onKnot[s] >= 0 ? cps[onKnot[s]] : vec2(numerators[s] / denominators[s]);
+		}
+		return vertices;
 	}
 };
 
 class LagrangeApp : public glApp {
 	LagrangeCurve* curve;
 	GPUProgram* gpuProgram;
+	GPUProgram* curveProgram;
 
 public:
 	LagrangeApp() : glApp("Lagrange Curve") {}
-	~LagrangeApp() { delete gpuProgram; delete curve; }
+	~LagrangeApp() { delete gpuProgram; delete curveProgram; delete curve; }
 
 	void onInitialization() override
 	{
 		glPointSize(10);
 		glLineWidth(3);
 
+		curveProgram = new GPUProgram(curveVertSource, fragSource);
 		gpuProgram = new GPUProgram(vertSource, fragSource);
 		curve = new LagrangeCurve;
 	}
@@ -161,7 +379,53 @@ public:
 		glClear(GL_COLOR_BUFFER_BIT);
 		glViewport(0, 0, winWidth, winHeight);
 
-		curve->Render(gpuProgram);
+		curve->Render(gpuProgram, curveProgram);
+	}
+
+	// t: next tessellation, +/-: GPU sample count,
+	// b: benchmark and comparison with the product form, 12 random control points, then 200 more and 1000 moves
+	void onKeyboard(int key) override
+	{
+		if (key == 't')
+		{
+			int nVertices = curve->SetTessellation((Tessellation)((curve->GetTessellation() + 1) % 3));
+			printf("%s tessellation: %d curve vertices\n", tessellationNames[curve->GetTessellation()], nVertices);
+			refreshScreen();
+		}
+		if ((key == '+' || key == '-') && curve->GetTessellation() == TESSELLATION_GPU)
+		{
+			printf("%d GPU samples\n", curve->ScaleGpuSamples(key == '+' ? 2.0f : 0.5f));
+			refreshScreen();
+		}
+		if (key != 'b')
+			return;
+
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> coord(-0.5f, 0.5f);
+		LagrangeCurve test;
+		test.SetTessellation(TESSELLATION_UNIFORM); // compared sample by sample
+		for (int i = 0; i < 12; i++) test.AddControlPoint(vec2(coord(rng), coord(rng)));
+		for (int i = 0; i < 100; i++) test.MoveControlPoint(i % 12, vec2(coord(rng), coord(rng)));
+
+		auto start = std::chrono::high_resolution_clock::now();
+		float maxError = 0, maxValue = 0;
+		for (int s = 0; s <= nTessVertices; s++)
+		{
+			vec2 expected = LagrangeProduct(test.ControlPoints(), test.Knots(), (float)s / nTessVertices);
+			maxError = max(maxError, length(test.CurvePoints()[s] - expected));
+			maxValue = max(maxValue, length(expected));
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		printf("12 control points: product form %.3f ms, largest difference %g (relative %g)\n",
+			std::chrono::duration<float, std::milli>(end - start).count(), maxError, maxError / maxValue);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < 200; i++) test.AddControlPoint(vec2(coord(rng), coord(rng)));
+		auto added = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < 1000; i++) test.MoveControlPoint(i % 212, vec2(coord(rng), coord(rng)));
+		end = std::chrono::high_resolution_clock::now();
+		printf("200 adds %.3f ms, 1000 moves %.3f ms\n", std::chrono::duration<float, std::milli>(added - start).count(),
+			std::chrono::duration<float, std::milli>(end - added).count());
 	}
 
 	void onMousePressed(MouseButton but, int pX, int pY) override
@@ -2,6 +2,8 @@
 
 #include <iostream>
 #include <list>
+#include <algorithm>
+#include <float.h>
 
 const char* vertSource = R"(
 	#version 330				
@@ -39,7 +41,7 @@ class Framebuffer
 	unsigned int textureId = 0;
 
 public:
-	Framebuffer(int width, int height, vec3* data)
+	Framebuffer(PixelBuffer& image)
 	{
 		// setup VAO
 		glGenVertexArrays(1, &vao);
@@ -63,14 +65,19 @@ public:
 		// setup texture
 		glGenTextures(1, &textureId);
 		glBindTexture(GL_TEXTURE_2D, textureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, data);
+		image.Upload(true);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	}
-	void Update(int width, int height, vec3* data)
+	void Update(PixelBuffer& image)
 	{
 		glBindTexture(GL_TEXTURE_2D, textureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, data);
+		image.Upload();
+	}
+	void Update(PixelBuffer& image, int x, int y, int width, int height)
+	{
+		glBindTexture(GL_TEXTURE_2D, textureId);
+		image.Upload(x, y, width, height);
 	}
 	void Bind(int textureUnit)
 	{
@@ -95,32 +102,96 @@ public:
 	}
 };
 
+// x interval of the row where A x^2 + B x + C > 0, for A <= 0 (a single, possibly unbounded interval)
+bool QuadraticSpan(float A, float B, float C, float& x0, float& x1)
+{
+	if (fabsf(A) < 1e-9f)
+	{
+		if (B == 0) { x0 = -FLT_MAX; x1 = FLT_MAX; return C > 0; }
+		if (B > 0) { x0 = -C / B; x1 = FLT_MAX; }
+		else { x0 = -FLT_MAX; x1 = -C / B; }
+		return true;
+	}
+	float disc = B * B - 4 * A * C;
+	if (disc <= 0) return false;
+	float q = -0.5f * (B + (B < 0 ? -sqrtf(disc) : sqrtf(disc))); // stable roots
+	x0 = q / A; x1 = (q != 0) ? C / q : x0;
+	if (x0 > x1) std::swap(x0, x1);
+	return true;
+}
+
 struct Object {
 	vec3 color;
+	vec2 bbMin = vec2(-FLT_MAX), bbMax = vec2(FLT_MAX); // bounding box in window coordinates
 	Object(vec3 c) : color(c) { }
 	virtual bool In(vec2 r) = 0;
+	// the points of the horizontal line at y that are In() are the ones with x0 < x < x1 (up to rounding)
+	virtual bool Span(float y, float& x0, float& x1) = 0;
 };
 struct Circle : Object {
 	vec2 center;
 	float R;
-	Circle(vec3 c, vec2 cen, float r) : Object(c), center(cen), R(r) {}
+	Circle(vec3 c, vec2 cen, float r) : Object(c), center(cen), R(r) { bbMin = center - R; bbMax = center + R; }
 	bool In(vec2 r) { return (dot(r - center, r - center) < R * R); }
+	bool Span(float y, float& x0, float& x1)
+	{
+		float dy = y - center.y;
+		if (dy * dy >= R * R) return false;
+		float halfWidth = sqrtf(R * R - dy * dy);
+		x0 = center.x - halfWidth; x1 = center.x + halfWidth;
+		return true;
+	}
 };
 struct HalfPlane : Object {
 	vec2 r0, n;
 	HalfPlane(vec3 c, vec2 r, vec2 n) : Object(c), r0(r), n(normalize(n)) {}
 	bool In(vec2 r) { return (dot(r - r0, n) < 0); }
+	bool Span(float y, float& x0, float& x1)
+	{
+		// n.x * x + n.y * (y - r0.y) - n.x * r0.x < 0
+		return QuadraticSpan(0.0f, -n.x, n.x * r0.x - n.y * (y - r0.y), x0, x1);
+	}
 };
 struct GeneralEllipse : Object {
 	vec2 f1, f2;
 	float C;
-	GeneralEllipse(vec3 c, vec2 f1, vec2 f2, float C) : Object(c), f1(f1), f2(f2), C(C) {}
+	vec2 center, u, v;	// center and axes
+	float a, b;			// semi-axes
+	GeneralEllipse(vec3 c, vec2 f1, vec2 f2, float C) : Object(c), f1(f1), f2(f2), C(C)
+	{
+		center = (f1 + f2) / 2.0f;
+		u = (f1 != f2) ? normalize(f2 - f1) : vec2(1, 0);
+		v = vec2(-u.y, u.x);
+		a = C / 2;
+		b = sqrtf(max(a * a - dot(f2 - center, f2 - center), 0.0f));
+		vec2 halfSize(sqrtf(a * a * u.x * u.x + b * b * v.x * v.x), sqrtf(a * a * u.y * u.y + b * b * v.y * v.y));
+		bbMin = center - halfSize; bbMax = center + halfSize;
+	}
 	bool In(vec2 r) { return (length(r - f1) + length(r - f2) < C); }
+	bool Span(float y, float& x0, float& x1)
+	{
+		if (b <= 0) return false;
+		// (dot(r - center, u) / a)^2 + (dot(r - center, v) / b)^2 < 1, quadratic in X = x - center.x
+		float Y = y - center.y;
+		float A = u.x * u.x / (a * a) + v.x * v.x / (b * b);
+		float B = 2 * Y * (u.x * u.y / (a * a) + v.x * v.y / (b * b));
+		float C0 = Y * Y * (u.y * u.y / (a * a) + v.y * v.y / (b * b)) - 1;
+		if (!QuadraticSpan(-A, -B, -C0, x0, x1)) return false;
+		x0 += center.x; x1 += center.x;
+		return true;
+	}
 };
 struct Parabola : Object {
 	vec2 f, r0, n;
 	Parabola(vec3 c, vec2 f, vec2 r0, vec2 n) : Object(c), f(f), r0(r0), n(normalize(n)) {}
 	bool In(vec2 r) { return (fabs(dot(r - r0, n)) > length(r - f)); }
+	bool Span(float y, float& x0, float& x1)
+	{
+		// (n.x * x + k)^2 > (x - f.x)^2 + (y - f.y)^2
+		float k = n.y * (y - r0.y) - n.x * r0.x;
+		float A = n.x * n.x - 1, B = 2 * (n.x * k + f.x), C = k * k - f.x * f.x - (y - f.y) * (y - f.y);
+		return QuadraticSpan(A, B, C, x0, x1);
+	}
 };
 
 
@@ -129,7 +200,8 @@ class PixelDrivenRendering : public glApp
 	Framebuffer* fb;
 	GPUProgram* gpuProgram;
 
-	vec3 image[winHeight * winWidth];
+	PixelBuffer image = PixelBuffer(winWidth, winHeight, PIXEL_RGBA8);
+	std::vector<Object*> idBuffer = std::vector<Object*>(winWidth * winHeight, nullptr); // front object per pixel
 
 	std::list<Object*> objs;
 	Object* picked = nullptr;
@@ -140,9 +212,9 @@ public:
 
 	void onInitialization()
 	{
-		memset(image, 0, sizeof(image));
+		image.Fill(vec3(0.0f));
 
-		fb = new Framebuffer(winWidth, winHeight, image);
+		fb = new Framebuffer(image);
 		gpuProgram = new GPUProgram(vertSource, fragSource);
 
 		objs.push_back(new HalfPlane{ {0, 1, 0}, {-0.2f, -0.5f}, {3, 1} });
@@ -169,16 +241,7 @@ public:
 	}
 	void Pick(int pX, int pY)
 	{
-		vec2 wPoint = Viewport2Window(pX, pY);
-		picked = nullptr;
-		for (auto o : objs)
-		{
-			if (o->In(wPoint))
-			{
-				picked = o;
-				return;
-			}
-		}
+		picked = (pX >= 0 && pX < winWidth && pY >= 0 && pY < winHeight) ? idBuffer[pY * winWidth + pX] : nullptr;
 	}
 	void BringToFront()
 	{
@@ -188,28 +251,81 @@ public:
 			objs.push_front(picked);
 		}
 	}
-	void Render()
+	void Render() { Render(0, 0, winWidth - 1, winHeight - 1); }
+
+	// row by row, every object fills the not yet covered pixels of its span, front to back;
+	// only the pixels of [rx0, rx1] x [ry0, ry1] are rendered and uploaded
+	void Render(int rx0, int ry0, int rx1, int ry1)
 	{
-		for (int pX = 0; pX < winWidth; pX++) for (int pY = 0; pY < winHeight; pY++)
+		std::vector<int> nextFree(winWidth + 1); // first uncovered pixel at or after x (with path compression)
+		auto find = [&](int x) {
+			int root = x;
+			while (nextFree[root] != root) root = nextFree[root];
+			while (nextFree[x] != root) { int next = nextFree[x]; nextFree[x] = root; x = next; }
+			return root;
+		};
+
+		float wx0 = Viewport2Window(rx0, 0).x, wx1 = Viewport2Window(rx1, 0).x;
+		for (int pY = ry0; pY <= ry1; pY++)
 		{
-			vec2 wPoint = Viewport2Window(pX, pY);
+			float y = Viewport2Window(0, pY).y;
+			for (int x = rx0; x <= rx1 + 1; x++) nextFree[x] = x;
+			std::fill(&idBuffer[pY * winWidth + rx0], &idBuffer[pY * winWidth + rx1] + 1, nullptr);
+
 			for (auto o : objs)
 			{
-				if (o->In(wPoint))
+				float x0, x1;
+				if (y < o->bbMin.y || y > o->bbMax.y || wx1 < o->bbMin.x || wx0 > o->bbMax.x || !o->Span(y, x0, x1)) continue;
+
+				int pStart, pEnd;
+				if (!SpanPixels(o, pY, x0, x1, pStart, pEnd)) continue;
+				for (int pX = find(clamp(pStart, rx0, rx1 + 1)); pX <= min(pEnd, rx1); pX = find(pX + 1))
 				{
-					image[pY * winWidth + pX] = o->color;
-					break;
+					image.Set(pX, pY, o->color);
+					idBuffer[pY * winWidth + pX] = o;
+					nextFree[pX] = pX + 1;
 				}
+				if (find(rx0) > rx1) break; // row done
 			}
 		}
-		fb->Update(winWidth, winHeight, image);
+		fb->Update(image, rx0, ry0, rx1 - rx0 + 1, ry1 - ry0 + 1);
+	}
+
+	// pixel rectangle around the bounding box of the object, clipped to the window
+	void BoundingRect(Object* o, int& x0, int& y0, int& x1, int& y1)
+	{
+		x0 = (int)floorf(clamp((o->bbMin.x + 1.0f) * winWidth / 2.0f, 0.0f, winWidth - 1.0f));
+		x1 = (int)ceilf(clamp((o->bbMax.x + 1.0f) * winWidth / 2.0f, 0.0f, winWidth - 1.0f));
+		y0 = (int)floorf(clamp((1.0f - o->bbMax.y) * winHeight / 2.0f, 0.0f, winHeight - 1.0f));
+		y1 = (int)ceilf(clamp((1.0f - o->bbMin.y) * winHeight / 2.0f, 0.0f, winHeight - 1.0f));
+	}
+
+	// pixel range of the span, the ends are corrected with In() so rounding cannot change the image
+	bool SpanPixels(Object* o, int pY, float x0, float x1, int& pStart, int& pEnd)
+	{
+		auto inside = [&](int pX) { return o->In(Viewport2Window(pX, pY)); };
+		pStart = (int)ceilf(clamp((x0 + 1.0f) * winWidth / 2.0f, -1.0f, (float)winWidth));
+		pEnd = (int)floorf(clamp((x1 + 1.0f) * winWidth / 2.0f, -1.0f, (float)winWidth));
+		pStart = clamp(pStart, 0, winWidth - 1);
+		pEnd = clamp(pEnd, 0, winWidth - 1);
+
+		while (pStart > 0 && inside(pStart - 1)) pStart--;
+		while (pStart <= pEnd && !inside(pStart)) pStart++;
+		while (pEnd < winWidth - 1 && inside(pEnd + 1)) pEnd++;
+		while (pEnd >= pStart && !inside(pEnd)) pEnd--;
+		return pStart <= pEnd;
 	}
 
 	void onMousePressed(MouseButton but, int pX, int pY)
 	{
 		Pick(pX, pY);
+		if (!picked) return;
+
+		// only the pixels of the picked object can change
 		BringToFront();
-		Render();
+		int x0, y0, x1, y1;
+		BoundingRect(picked, x0, y0, x1, y1);
+		Render(x0, y0, x1, y1);
 		refreshScreen();
 	}
 
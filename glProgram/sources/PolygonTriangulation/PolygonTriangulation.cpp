@@ -2,6 +2,10 @@
 // Polygon Triangulation
 //=============================================================================================
 #include "framework.h"
+#include "triangulation.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
 
 // cscspont rnyal
 const char* vertSource = R"(
@@ -94,15 +98,104 @@ public:
 	}
 };
 
+// twice the signed area of a ring
+double RingArea2(const std::vector<vec2>& ring)
+{
+	double area2 = 0;
+	for (size_t i = 0; i < ring.size(); i++)
+	{
+		vec2 p = ring[i], q = ring[(i + 1) % ring.size()];
+		area2 += (double)p.x * q.y - (double)q.x * p.y;
+	}
+	return area2;
+}
+
+// fuzz test of the engines against the area of the polygon: random star polygons with up to 200
+// vertices, half of them with a hole and half of them snapped to a 1/32 grid (collinear vertices and
+// equal y coordinates); a triangulation fails if a triangle is clockwise or the areas differ
+void FuzzTriangulators(const std::vector<std::pair<const char*, Triangulator*>>& engines, int nPolygons, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+	// counterclockwise around the origin, every angular gap is less than pi
+	auto starPolygon = [&](int n, float rMin, float rMax, bool snap) {
+		std::vector<vec2> ring(n);
+		for (int i = 0; i < n; i++)
+		{
+			float a = 2 * (float)M_PI * (i + 0.4f * uniform(rng)) / n;
+			float r = rMin + (rMax - rMin) * uniform(rng);
+			ring[i] = vec2(r * cosf(a), r * sinf(a));
+			if (snap) ring[i] = round(ring[i] * 32.0f) / 32.0f;
+		}
+		return ring;
+	};
+	// snapping may merge vertices or break the order around the origin
+	auto aroundOrigin = [](const std::vector<vec2>& ring, int turn) {
+		for (size_t i = 0; i < ring.size(); i++)
+			if (orient2D(vec2(0, 0), ring[i], ring[(i + 1) % ring.size()]) != turn) return false;
+		return true;
+	};
+
+	int nTested = 0;
+	std::vector<int> failures(engines.size(), 0);
+	std::vector<double> maxError(engines.size(), 0.0);
+	for (int polygon = 0; polygon < nPolygons; polygon++)
+	{
+		int n = 3 + rng() % 198;
+		bool snap = polygon % 2 == 1, withHole = polygon % 4 >= 2 && n >= 8; // the hole stays inside from 8 vertices
+		std::vector<vec2> outer = starPolygon(n, 0.3f, 0.9f, snap);
+		if (!aroundOrigin(outer, 1)) continue;
+		std::vector<std::vector<vec2>> holes;
+		if (withHole)
+		{
+			std::vector<vec2> hole = starPolygon(3 + rng() % 20, 0.05f, 0.2f, snap);
+			if (!aroundOrigin(hole, 1)) continue;
+			if (rng() % 2) std::reverse(hole.begin(), hole.end()); // either orientation
+			holes.push_back(hole);
+		}
+		nTested++;
+
+		double expected = fabs(RingArea2(outer)) - (holes.empty() ? 0.0 : fabs(RingArea2(holes[0])));
+		std::vector<vec2> vertices = outer;
+		for (auto& hole : holes) vertices.insert(vertices.end(), hole.begin(), hole.end());
+
+		for (size_t e = 0; e < engines.size(); e++)
+		{
+			std::vector<unsigned int> indices = engines[e].second->Triangulate(outer, holes);
+			double area = 0.0;
+			bool clockwise = false;
+			for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				double triangleArea = RingArea2({ vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]] });
+				clockwise = clockwise || triangleArea < 0;
+				area += triangleArea;
+			}
+			double error = fabs(area - expected) / expected;
+			maxError[e] = max(maxError[e], error);
+			if ((clockwise || error > 1e-5) && failures[e]++ == 0)
+				printf("%s fails on polygon %d: %d vertices, %s, area %g instead of %g\n", engines[e].first, polygon,
+					(int)vertices.size(), holes.empty() ? "no hole" : "with hole", area / 2, expected / 2);
+		}
+	}
+	for (size_t e = 0; e < engines.size(); e++)
+		printf("%s: %d polygons, %d failures, largest relative area error %.2g\n", engines[e].first, nTested, failures[e], maxError[e]);
+}
+
 class PolygonTriangulation : public glApp 
 {
 	ColoredGeometry<vec2>* polyLines;
+	ColoredGeometry<vec2>* holeLines;
 	ColoredGeometry<vec2>* polyTriangles;
 	GPUProgram* gpuProgram;
+	EarClipper earClipper;
+	MonotoneTriangulator monotoneTriangulator;
+	Triangulator* triangulator = &earClipper;
+	bool withHole = false;
 
 public:
 	PolygonTriangulation() : glApp("Polygon Triangulation") {}
-	~PolygonTriangulation() { delete polyLines; delete polyTriangles; delete gpuProgram; }
+	~PolygonTriangulation() { delete polyLines; delete holeLines; delete polyTriangles; delete gpuProgram; }
 
 	// Inicializci, 
 	void onInitialization() 
@@ -110,6 +203,7 @@ public:
 		srand(time(NULL));
 
 		polyLines = new ColoredGeometry<vec2>;
+		holeLines = new ColoredGeometry<vec2>;
 		polyTriangles = new ColoredGeometry<vec2>;
 
 		gpuProgram = new GPUProgram(vertSource, fragSource);
@@ -128,6 +222,49 @@ public:
 
 		polyTriangles->Draw(gpuProgram, GL_TRIANGLES);
 		polyLines->Draw(gpuProgram, GL_LINE_LOOP);
+		if (withHole) holeLines->Draw(gpuProgram, GL_LINE_LOOP);
+	}
+
+	// h: polygon with or without a hole, m: ear clipping / monotone partition,
+	// space: triangulate a 100k-vertex polygon and measure it, f: fuzz test of both engines
+	void onKeyboard(int key)
+	{
+		if (key == 'm')
+		{
+			triangulator = triangulator == &earClipper ? (Triangulator*)&monotoneTriangulator : &earClipper;
+			printf("%s\n", triangulator == &earClipper ? "ear clipping" : "monotone partition");
+			Recalculate();
+			refreshScreen();
+		}
+		else if (key == 'h')
+		{
+			withHole = !withHole;
+			Recalculate();
+			refreshScreen();
+		}
+		else if (key == 'f')
+		{
+			FuzzTriangulators({ { "ear clipping", &earClipper }, { "monotone partition", &monotoneTriangulator } }, 10000, 42);
+		}
+		else if (key == ' ')
+		{
+			const int nVertices = 100000;
+			std::vector<vec2> outer;
+			outer.reserve(nVertices);
+			for (int i = 0; i < nVertices; i++)
+			{
+				float a = 2 * M_PI * i / nVertices;
+				float r = 0.7f + 0.15f * sinf(7 * a) + (rand() % 100) / 100.0f * 0.002f;
+				outer.push_back(vec2(r * cosf(a), r * sinf(a)));
+			}
+			std::vector<std::vector<vec2>> holes(1, GenerateVertices(nVertices / 100, 0.3f, 0.0f));
+
+			auto start = std::chrono::high_resolution_clock::now();
+			size_t nIndices = triangulator->Triangulate(outer, holes).size();
+			auto end = std::chrono::high_resolution_clock::now();
+			printf("%d vertices: %d triangles, %.3f ms\n", nVertices + nVertices / 100, (int)nIndices / 3,
+				std::chrono::duration<float, std::milli>(end - start).count());
+		}
 	}
 
 	void onMousePressed(MouseButton but, int pX, int pY)
@@ -142,9 +279,24 @@ public:
 		polyLines->Col().resize(polyLines->Vtx().size(), vec3(1.0f, 1.0f, 1.0f));
 		polyLines->updateGPU();
 
-		polyTriangles->Vtx() = Triangulate(polyLines->Vtx());
+		std::vector<std::vector<vec2>> holes;
+		if (withHole)
+		{
+			holeLines->Vtx() = GenerateVertices(6, 0.2f, 0.05f);
+			holeLines->Col().resize(holeLines->Vtx().size(), vec3(1.0f, 1.0f, 1.0f));
+			holeLines->updateGPU();
+			holes.push_back(holeLines->Vtx());
+		}
+
+		// the indices address the outer vertices followed by the hole vertices
+		std::vector<vec2> vertices = polyLines->Vtx();
+		for (auto& hole : holes) vertices.insert(vertices.end(), hole.begin(), hole.end());
+
+		polyTriangles->Vtx().clear();
 		polyTriangles->Col().clear();
-		for (int i = 0; i < polyLines->Vtx().size(); i++)
+		for (unsigned int i : triangulator->Triangulate(polyLines->Vtx(), holes))
+			polyTriangles->Vtx().push_back(vertices[i]);
+		for (int i = 0; i < polyTriangles->Vtx().size(); i += 3)
 		{
 			vec3 color{ (rand() % 100) / 100.0f, (rand() % 100) / 100.0f, (rand() % 100) / 100.0f };
 			polyTriangles->Col().push_back(color);
@@ -154,95 +306,6 @@ public:
 		polyTriangles->updateGPU();
 	}
 
-	std::vector<vec2> Triangulate(const std::vector<vec2>& v)
-	{
-		std::vector<vec2> vertices = v;
-		std::vector<vec2> triangles;
-		triangles.reserve((vertices.size() - 2) * 3);
-
-		while (vertices.size() >= 3)
-		{
-			int vIdx = FindEar(vertices);
-			if (vIdx == -1) break;
-
-			// add new triangle
-			int prevIdx = (vIdx - 1 + vertices.size()) % vertices.size();
-			int nextIdx = (vIdx + 1) % vertices.size();
-			triangles.push_back(vertices[prevIdx]);
-			triangles.push_back(vertices[vIdx]);
-			triangles.push_back(vertices[nextIdx]);
-			
-			// remove the ear vertex
-			vertices.erase(vertices.begin() + vIdx);
-		}
-
-		return triangles;
-	}
-
-	int FindEar(const std::vector<vec2>& v)
-	{
-		if (v.size() < 3) return -1;
-
-		int diagIdx = -1;
-		for (int i = 0; i < v.size(); i++)
-		{
-			diagIdx = i;
-			int prevIdx = (i - 1 + v.size()) % v.size();
-			int nextIdx = (i + 1) % v.size();
-			
-			// search for edge intersections (enough vertices are needed)
-			if (v.size() > 4)
-			{
-				for (int j = 0; j < v.size() - 4; j++)
-				{
-					// edge indices
-					int i1 = (i - 2 - j + v.size()) % v.size();
-					int i2 = (i - 3 - j + v.size()) % v.size();
-					if (LineIntersect(v[prevIdx], v[nextIdx], v[i1], v[i2]))
-					{
-						diagIdx = -1; // edge intersection found
-						break;
-					}
-				}
-			}
-
-			// not a diagonal
-			if (diagIdx == -1) continue;
-
-			// triangle is always an ear
-			if (v.size() == 3) return diagIdx;
-			
-			// calculate the maximum x coord for the half line
-			float xMax = v[0].x;
-			for (int j = 1; j < v.size(); j++)
-				if (v[j].x > xMax)
-					xMax = v[j].x;
-			xMax += 0.01f; // to avoid precision issues
-
-			// see if it goes fully outside of the polygon
-			vec2 halfPoint = (v[prevIdx] + v[nextIdx]) * 0.5f;
-			int c = 0;
-			for (int j = 0; j < v.size(); j++)
-				if (LineIntersect(halfPoint, { xMax, halfPoint.y }, v[j], v[(j + 1) % v.size()]))
-					c++;
-			
-			if (c % 2 == 1) return diagIdx;
-		}
-
-		return -1;
-	}
-
-	bool LineIntersect(const vec2& l1, const vec2& l2, const vec2& r1, const vec2& r2)
-	{
-		vec2 ln = l2 - l1; ln = vec2(-ln.y, ln.x);
-		if (dot(ln, (r1 - l1)) * dot(ln, (r2 - l1)) > 0) return false;
-		
-		vec2 rn = r2 - r1; rn = vec2(-rn.y, rn.x);
-		if (dot(rn, (l1 - r1)) * dot(rn, (l2 - r1)) > 0) return false;
-		
-		return true;
-	}
-
 	std::vector<vec2> GenerateVertices(int count, float r, float noise)
 	{
 		/*{ vec2(-0.8f, -0.8f), vec2(-0.7f, 0.8f), vec2(-0.1f, 0.1f), vec2(0.8f, 0.4f), vec2(0.9f, -0.4f), vec2(0.3f, -0.85f) }*/
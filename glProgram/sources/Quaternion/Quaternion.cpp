@@ -190,8 +190,6 @@ struct VertexData
 //---------------------------
 class ParamSurface : public Geometry<VertexData> {
 
-	int nVtxPerStrip, nStrips;
-
 	vec3 translation, scaling;
 	vec4 quaternion;
 
@@ -200,9 +198,7 @@ public:
 	Texture* texture;
 
 	ParamSurface(vec3 position, Material* material, Texture* texture)
-		: translation(position), scaling(1.0f), quaternion(vec4(0.0f, 0.0f, 0.0f, 1.0f)), material(material), texture(texture) {
-		nVtxPerStrip = nStrips = 0;
-	}
+		: translation(position), scaling(1.0f), quaternion(vec4(0.0f, 0.0f, 0.0f, 1.0f)), material(material), texture(texture) { }
 
 	void Rotate(vec4 delta) { quaternion = normalize(qmul(delta, quaternion)); }
 
@@ -221,15 +217,13 @@ public:
 	}
 
 	void create(int N = tessellationLevel, int M = tessellationLevel) {
-		nVtxPerStrip = (M + 1) * 2;
-		nStrips = N;
 		vtx.clear();
-		for (int i = 0; i < N; i++) {
+		for (int i = 0; i <= N; i++) {
 			for (int j = 0; j <= M; j++) {
 				vtx.push_back(GenVertexData((float)j / M, (float)i / N));
-				vtx.push_back(GenVertexData((float)j / M, (float)(i + 1) / N));
 			}
 		}
+		GridStrips(N, M); // every grid vertex once, the strips index them
 		// Enable the vertex attribute arrays
 		glEnableVertexAttribArray(0);  // attribute array 0 = POSITION
 		glEnableVertexAttribArray(1);  // attribute array 1 = NORMAL
@@ -262,9 +256,7 @@ public:
 		gpuProgram->setUniform(0, "diffuseTexture");
 		texture->Bind(0);
 
-		Bind();
-		for (unsigned int i = 0; i < nStrips; i++)
-			glDrawArrays(GL_TRIANGLE_STRIP, i * nVtxPerStrip, nVtxPerStrip);
+		DrawStrips();
 	}
 };
 
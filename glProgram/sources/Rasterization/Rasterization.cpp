@@ -2,6 +2,10 @@
 // Rasterization
 //=============================================================================================
 #include "framework.h"
+#include "rasterizer.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
 
 const char* vertSource = R"(
 	#version 330				
@@ -39,7 +43,7 @@ class Framebuffer
 	unsigned int textureId = 0;
 
 public:
-	Framebuffer(int width, int height, vec3* data)
+	Framebuffer(PixelBuffer& image)
 	{
 		// setup VAO
 		glGenVertexArrays(1, &vao);
@@ -63,14 +67,14 @@ public:
 		// setup texture
 		glGenTextures(1, &textureId);
 		glBindTexture(GL_TEXTURE_2D, textureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, data);
+		image.Upload(true);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	}
-	void Update(int width, int height, vec3* data)
+	void Update(PixelBuffer& image)
 	{
 		glBindTexture(GL_TEXTURE_2D, textureId);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_FLOAT, data);
+		image.Upload();
 	}
 	void Bind(int textureUnit)
 	{
@@ -95,36 +99,81 @@ public:
 	}
 };
 
+// Flat colored triangles into a PixelBuffer with the shared half-space rasterizer
+class TileRasterizer : public HalfSpaceRasterizer
+{
+	struct Triangle : Edges
+	{
+		uint64_t color;				// packed in the format of the image
+	};
+
+	PixelBuffer* image;
+	std::vector<Triangle> triangles;
+
+public:
+	TileRasterizer(PixelBuffer* _image) : HalfSpaceRasterizer(_image->Width(), _image->Height()), image(_image) { }
+
+	// vertices in pixel coordinates, the pixel (x, y) is sampled at (x + 0.5, y + 0.5);
+	// they have to stay within +-32K pixels (clip beforehand)
+	void AddTriangle(vec2 p1, vec2 p2, vec2 p3, const vec3& color)
+	{
+		int X[3] = { (int)lroundf(p1.x * One), (int)lroundf(p2.x * One), (int)lroundf(p3.x * One) };
+		int Y[3] = { (int)lroundf(p1.y * One), (int)lroundf(p2.y * One), (int)lroundf(p3.y * One) };
+
+		long long area = Area2(X, Y);
+		if (area == 0) return;
+		if (area < 0) std::swap(X[1], X[2]), std::swap(Y[1], Y[2]);
+
+		Triangle tri;
+		if (!SetupEdges(X, Y, tri)) return;
+		tri.color = image->Pack(color);
+
+		triangles.push_back(tri);
+		Bin(tri, (int)triangles.size() - 1);
+	}
+
+	// rasterize the binned triangles, one tile at a time per thread
+	void Flush(int nThreads = (int)std::thread::hardware_concurrency())
+	{
+		FlushTiles(nThreads, [&](int index, int minX, int minY, int maxX, int maxY) {
+			const Triangle& tri = triangles[index];
+			Rasterize(tri, minX, minY, maxX, maxY, [&](int x, int y) { image->SetPacked(image->Index(x, y), tri.color); });
+		});
+		triangles.clear();
+	}
+};
+
 class Rasterization : public glApp
 {
 	Framebuffer* fb;
 	GPUProgram* gpuProgram;
+	TileRasterizer* rasterizer;
 
-	vec3 image[winWidth * winHeight];
+	PixelBuffer image = PixelBuffer(winWidth, winHeight, PIXEL_RGBA8, LAYOUT_TILED);
 
 public:
 	Rasterization() : glApp("Rasterization") { }
-	~Rasterization() { delete fb; delete gpuProgram; }
+	~Rasterization() { delete fb; delete gpuProgram; delete rasterizer; }
 
 	// Inicializci, 
 	void onInitialization() 
 	{
-		memset(image, 0, sizeof(image));
+		image.Fill(vec3(0.0f));
+		rasterizer = new TileRasterizer(&image);
 		
-		DrawLine(image, 250, 100, 100, 500, vec3(1.0f, 1.0f, 0.0f));
-		DrawLine(image, 100, 250, 250, 250, vec3(0.0f, 1.0f, 1.0f));
-		DrawLine(image, 150, 200, 150, 450, vec3(1.0f, 0.0f, 1.0f));
-
-		DrawTriangle(image, 480, 560, 520, 400, 350, 500, vec3(1.0f, 0.0f, 0.0f));
-		DrawTriangle(image, 550, 200, 580, 100, 500, 120, vec3(0.0f, 1.0f, 0.0f));
-		DrawTriangle(image, 400, 550, 550, 450, 390, 300, vec3(0.0f, 0.0f, 1.0f));
-		DrawTriangle(image, 310, 310, 580, 350, 500, 200, vec3(1.0f, 1.0f, 0.0f));
-		DrawTriangle(image, 470, 480, 490, 430, 520, 520, vec3(1.0f, 0.0f, 1.0f));
-		DrawTriangle(image, 360, 100, 580, 200, 400, 300, vec3(0.0f, 1.0f, 1.0f));
+		DrawLine(250, 100, 100, 500, vec3(1.0f, 1.0f, 0.0f));
+		DrawLine(100, 250, 250, 250, vec3(0.0f, 1.0f, 1.0f));
+		DrawLine(150, 200, 150, 450, vec3(1.0f, 0.0f, 1.0f));
 
+		DrawTriangle(480, 560, 520, 400, 350, 500, vec3(1.0f, 0.0f, 0.0f));
+		DrawTriangle(550, 200, 580, 100, 500, 120, vec3(0.0f, 1.0f, 0.0f));
+		DrawTriangle(400, 550, 550, 450, 390, 300, vec3(0.0f, 0.0f, 1.0f));
+		DrawTriangle(310, 310, 580, 350, 500, 200, vec3(1.0f, 1.0f, 0.0f));
+		DrawTriangle(470, 480, 490, 430, 520, 520, vec3(1.0f, 0.0f, 1.0f));
+		DrawTriangle(360, 100, 580, 200, 400, 300, vec3(0.0f, 1.0f, 1.0f));
+		rasterizer->Flush();
 
-		fb = new Framebuffer(winWidth, winHeight, image);
-		fb->Update(winWidth, winHeight, image);
+		fb = new Framebuffer(image);
 
 		gpuProgram = new GPUProgram(vertSource, fragSource);
 	}
@@ -139,7 +188,31 @@ public:
 		fb->Draw(gpuProgram);
 	}
 
-	void DrawLine(vec3* imageData, short x1, short y1, short x2, short y2, const vec3& color)
+	// space: rasterize lots of random triangles and measure it
+	void onKeyboard(int key)
+	{
+		if (key != ' ') return;
+
+		const int nTriangles = 10000;
+		static std::mt19937 rng(42);
+		std::uniform_real_distribution<float> pos(-20.0f, winWidth + 20.0f), offset(-40.0f, 40.0f), channel(0.0f, 1.0f);
+
+		image.Fill(vec3(0.0f));
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < nTriangles; i++)
+		{
+			vec2 p(pos(rng), pos(rng));
+			rasterizer->AddTriangle(p, p + vec2(offset(rng), offset(rng)), p + vec2(offset(rng), offset(rng)), vec3(channel(rng), channel(rng), channel(rng)));
+		}
+		rasterizer->Flush();
+		auto end = std::chrono::high_resolution_clock::now();
+		printf("%d triangles: %.3f ms\n", nTriangles, std::chrono::duration<float, std::milli>(end - start).count());
+
+		fb->Update(image);
+		refreshScreen();
+	}
+
+	void DrawLine(short x1, short y1, short x2, short y2, const vec3& color)
 	{
 		const int T = 12;
 
@@ -148,7 +221,7 @@ public:
 		{
 			if (y2 < y1) std::swap(y1, y2);
 			for (short y = y1; y <= y2; y++)
-				imageData[y * winWidth + x1] = color;
+				image.Set(x1, y, color);
 			
 			return;
 		}
@@ -164,63 +237,15 @@ public:
 		for (short x = x1; x <= x2; x++) 
 		{
 			short Y = y >> T; // trunc
-			imageData[Y * winWidth + x] = color;
+			image.Set(x, Y, color);
 			y = y + m;
 		}
 	}
 
-	void DrawTriangle(vec3* imageData, short x1, short y1, short x2, short y2, short x3, short y3, const vec3& color)
+	void DrawTriangle(short x1, short y1, short x2, short y2, short x3, short y3, const vec3& color)
 	{
-		// sort vertices by y coordinate (y1 <= y2 <= y3)
-		if (y1 > y2) std::swap(y1, y2), std::swap(x1, x2);
-		if (y1 > y3) std::swap(y1, y3), std::swap(x1, x3);
-		if (y2 > y3) std::swap(y2, y3), std::swap(x2, x3);
-
-		if (y1 == y3) return; // horizontal line (y1 = y2 = y3)
-
-		// top triangle
-		if (y2 > y1)
-		{
-			// mm is the reciprocal of the slope
-			float mm12 = (x2 - x1) / (float)(y2 - y1);
-			float mm13 = (x3 - x1) / (float)(y3 - y1);
-			
-			float xStart = x1, xEnd = x1;
-
-			if (x2 < x1) std::swap(mm12, mm13);
-			
-			for (int y = y1; y <= y2; y++)
-			{
-				if (xStart > xEnd) std::swap(xStart, xEnd);
-				for (int x = xStart; x <= xEnd; ++x)
-					imageData[y * winWidth + x] = color;
-
-				xStart += mm13;
-				xEnd += mm12;
-			}
-		}
-
-		// bottom triangle
-		if (y3 > y2)
-		{
-			float mm13 = (x3 - x1) / (float)(y3 - y1);
-			float mm23 = (x3 - x2) / (float)(y3 - y2);
-
-			float xStart = x1 + mm13 * (y2 - y1);
-			float xEnd = x2;
-			
-			if (x2 < x1) std::swap(mm13, mm23);
-
-			for (int y = y2; y <= y3; y++)
-			{
-				if (xStart > xEnd) std::swap(xStart, xEnd);
-				for (int x = xStart; x <= xEnd; ++x)
-					imageData[y * winWidth + x] = color;
-
-				xStart += mm13;
-				xEnd += mm23;
-			}
-		}
+		// binned into the rasterizer of image, drawn at the next Flush()
+		rasterizer->AddTriangle(vec2(x1, y1), vec2(x2, y2), vec2(x3, y3), color);
 	}
 
 } app;
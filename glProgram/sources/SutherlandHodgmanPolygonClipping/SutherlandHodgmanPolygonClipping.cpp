@@ -2,6 +2,11 @@
 // Sutherland-Hodgman polygon clipping algorithm
 //=============================================================================================
 #include "framework.h"
+#include "triangulation.h"
+#include "pointlocation.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
 
 // cscspont rnyal
 const char* vertSource = R"(
@@ -30,13 +35,558 @@ const char* fragSource = R"(
 
 const int winWidth = 600, winHeight = 600;
 
+//---------------------------
+// Sutherland-Hodgman clipping with all planes in one pass: every vertex is pushed through the
+// chain of planes right away, so there are no intermediate polygons, and the output buffers are
+// reused. Planes that the bounding box of a polygon is fully inside of are skipped.
+class PolygonClipper
+{
+public:
+	struct Plane { vec2 p0, n; }; // inside: dot(p - p0, n) >= 0
+	struct Polygon { const vec2* vertices; int count; };
+	static const int maxPlanes = 8;
+
+private:
+	struct Stage { vec2 first, prev; float firstDist, prevDist; bool started; };
+	Plane planes[maxPlanes];
+	int nPlanes = 0;
+	int active[maxPlanes]; // planes of the current polygon
+	int nActive = 0;
+	Stage stages[maxPlanes];
+	std::vector<vec4> bounds; // center and half size of the polygons of a batch
+	std::vector<unsigned int> masks; // planes to clip with, per polygon of a batch
+
+	static vec2 Intersect(vec2 a, vec2 b, float da, float db) { return a + da / (da - db) * (b - a); }
+
+	void Push(int stage, vec2 v, std::vector<vec2>& out)
+	{
+		if (stage == nActive) { out.push_back(v); return; }
+		Stage& s = stages[stage];
+		const Plane& plane = planes[active[stage]];
+		float d = dot(v - plane.p0, plane.n);
+		if (!s.started) { s.started = true; s.first = v; s.firstDist = d; }
+		else if ((s.prevDist >= 0.0f) != (d >= 0.0f)) Push(stage + 1, Intersect(s.prev, v, s.prevDist, d), out);
+		if (d >= 0.0f) Push(stage + 1, v, out);
+		s.prev = v;
+		s.prevDist = d;
+	}
+
+	// the closing edge of each stage, from its last vertex to its first one
+	void Close(int stage, std::vector<vec2>& out)
+	{
+		if (stage == nActive) return;
+		Stage& s = stages[stage];
+		if (s.started && (s.prevDist >= 0.0f) != (s.firstDist >= 0.0f))
+			Push(stage + 1, Intersect(s.prev, s.first, s.prevDist, s.firstDist), out);
+		Close(stage + 1, out);
+	}
+
+	static vec4 Bounds(const Polygon& polygon)
+	{
+		vec2 lo = polygon.vertices[0], hi = polygon.vertices[0];
+		for (int i = 1; i < polygon.count; i++)
+		{
+			lo = min(lo, polygon.vertices[i]);
+			hi = max(hi, polygon.vertices[i]);
+		}
+		return vec4((lo + hi) * 0.5f, (hi - lo) * 0.5f);
+	}
+
+	// bit i of the result is set if plane i cuts the box; ~0u if the box is outside of a plane
+	unsigned int Classify(const vec4& box) const
+	{
+		unsigned int mask = 0;
+		for (int i = 0; i < nPlanes; i++)
+		{
+			float d = dot(vec2(box) - planes[i].p0, planes[i].n);
+			float r = box.z * fabsf(planes[i].n.x) + box.w * fabsf(planes[i].n.y);
+			if (d + r < 0.0f) return ~0u;
+			if (d - r < 0.0f) mask |= 1u << i;
+		}
+		return mask;
+	}
+
+	void ClipWith(const Polygon& polygon, unsigned int mask, std::vector<vec2>& out)
+	{
+		nActive = 0;
+		for (int i = 0; i < nPlanes; i++)
+			if (mask & (1u << i)) active[nActive++] = i;
+		for (int i = 0; i < nActive; i++) stages[i].started = false;
+		for (int i = 0; i < polygon.count; i++) Push(0, polygon.vertices[i], out);
+		Close(0, out);
+	}
+
+public:
+	void SetPlanes(const Plane* p, int count)
+	{
+		nPlanes = min(count, maxPlanes);
+		for (int i = 0; i < nPlanes; i++) planes[i] = p[i];
+	}
+
+	// the clipped polygon is appended to out
+	void Clip(const Polygon& polygon, std::vector<vec2>& out)
+	{
+		if (polygon.count < 3) return;
+		unsigned int mask = Classify(Bounds(polygon));
+		if (mask != ~0u) ClipWith(polygon, mask, out);
+	}
+
+	// clipped polygon i is out[starts[i]] ... out[starts[i + 1] - 1]; the bounding boxes of four
+	// polygons are classified against a plane at a time with SSE2
+	void ClipBatch(const std::vector<Polygon>& polygons, std::vector<vec2>& out, std::vector<int>& starts)
+	{
+		int n = (int)polygons.size();
+		out.clear();
+		starts.resize(n + 1);
+		bounds.resize((n + 3) & ~3);
+		masks.resize(bounds.size());
+		for (int i = 0; i < n; i++) bounds[i] = polygons[i].count >= 3 ? Bounds(polygons[i]) : vec4(0.0f, 0.0f, -1.0f, -1.0f);
+		for (int i = n; i < (int)bounds.size(); i++) bounds[i] = vec4(0.0f, 0.0f, -1.0f, -1.0f);
+
+#ifdef FRAMEWORK_SSE2
+		const __m128 zero = _mm_setzero_ps(), signMask = _mm_set1_ps(-0.0f);
+		for (int i = 0; i < n; i += 4)
+		{
+			// transpose the boxes of four polygons
+			__m128 b0 = _mm_loadu_ps(&bounds[i].x), b1 = _mm_loadu_ps(&bounds[i + 1].x);
+			__m128 b2 = _mm_loadu_ps(&bounds[i + 2].x), b3 = _mm_loadu_ps(&bounds[i + 3].x);
+			_MM_TRANSPOSE4_PS(b0, b1, b2, b3); // center x, center y, half width, half height
+			__m128 clipped = zero, rejected = _mm_cmplt_ps(b2, zero); // empty polygons are rejected
+			for (int k = 0; k < nPlanes; k++)
+			{
+				__m128 nx = _mm_set1_ps(planes[k].n.x), ny = _mm_set1_ps(planes[k].n.y);
+				__m128 d = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(b0, _mm_set1_ps(planes[k].p0.x)), nx),
+									  _mm_mul_ps(_mm_sub_ps(b1, _mm_set1_ps(planes[k].p0.y)), ny));
+				__m128 r = _mm_add_ps(_mm_mul_ps(b2, _mm_andnot_ps(signMask, nx)), _mm_mul_ps(b3, _mm_andnot_ps(signMask, ny)));
+				rejected = _mm_or_ps(rejected, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+				__m128 cut = _mm_cmplt_ps(_mm_sub_ps(d, r), zero);
+				clipped = _mm_or_ps(clipped, _mm_and_ps(cut, _mm_castsi128_ps(_mm_set1_epi32(1 << k))));
+			}
+			clipped = _mm_or_ps(clipped, rejected); // ~0u
+			_mm_storeu_si128((__m128i*)&masks[i], _mm_castps_si128(clipped));
+		}
+#else
+		for (int i = 0; i < n; i++) masks[i] = bounds[i].z < 0.0f ? ~0u : Classify(bounds[i]);
+#endif
+
+		for (int i = 0; i < n; i++)
+		{
+			starts[i] = (int)out.size();
+			if (masks[i] == ~0u) continue;
+			if (masks[i] == 0) out.insert(out.end(), polygons[i].vertices, polygons[i].vertices + polygons[i].count);
+			else ClipWith(polygons[i], masks[i], out);
+		}
+		starts[n] = (int)out.size();
+	}
+};
+
+//---------------------------
+// Greiner-Hormann clipping of two simple, possibly concave polygons: the intersection points of
+// the edges are inserted into both vertex lists, marked as entry or exit, and the result is traced
+// along them. The edge pairs come from a grid of the clip edges instead of testing every pair.
+// A vertex on an edge of the other polygon is degenerate for the method, then the clip polygon
+// is moved by a tiny amount and the clipping is repeated; if 8 moves do not help, the result is empty.
+class BooleanClipper
+{
+public:
+	enum Operation { INTERSECTION, UNION, DIFFERENCE }; // difference: subject minus clip
+	struct Region
+	{
+		std::vector<vec2> outer;
+		std::vector<std::vector<vec2>> holes;
+		Region(std::vector<vec2> outer, std::vector<std::vector<vec2>> holes = {}) : outer(std::move(outer)), holes(std::move(holes)) {}
+	};
+
+private:
+	struct Node
+	{
+		vec2 p;
+		int next = -1, prev = -1;
+		int neighbor = -1;		// the same intersection in the other list, -1 for a polygon vertex
+		bool entry = false, visited = false;
+	};
+	struct Hit { int s, c; double sAlpha, cAlpha; vec2 p; };
+
+	std::vector<Node> nodes;
+	std::vector<Hit> hits;
+	std::vector<int> cellStart, cellEdges, stamp; // grid of the clip edges (compressed rows)
+	PolygonLocator locator;
+
+	static double Cross(dvec2 a, dvec2 b) { return a.x * b.y - a.y * b.x; }
+
+	static double SignedArea(const std::vector<vec2>& v)
+	{
+		double area = 0.0;
+		for (size_t i = 0, j = v.size() - 1; i < v.size(); j = i++) area += Cross(v[j], v[i]);
+		return area / 2.0;
+	}
+
+	// crossing number with the exact orientation, so it agrees with intersectSegments:
+	// 1 inside, 0 on the boundary, -1 outside
+	static int Locate(const std::vector<vec2>& v, vec2 q)
+	{
+		bool inside = false;
+		for (size_t i = 0, j = v.size() - 1; i < v.size(); j = i++)
+		{
+			vec2 a = v[j], b = v[i];
+			if (q.y < min(a.y, b.y) || q.y > max(a.y, b.y)) continue;
+			if ((a.y > q.y) != (b.y > q.y))
+			{
+				int o = orient2D(a, b, q);
+				if (o == 0) return 0;
+				if ((o > 0) == (b.y > a.y)) inside = !inside; // the edge passes on the right of q
+			}
+			else if (q.x >= min(a.x, b.x) && q.x <= max(a.x, b.x) && orient2D(a, b, q) == 0) return 0;
+		}
+		return inside ? 1 : -1;
+	}
+
+	// false if an intersection is degenerate
+	bool FindIntersections(const std::vector<vec2>& s, const std::vector<vec2>& c)
+	{
+		hits.clear();
+
+		vec2 lo = c[0], hi = c[0];
+		for (vec2 p : c) { lo = min(lo, p); hi = max(hi, p); }
+		int gridSize = clamp((int)sqrtf((float)c.size()), 1, 256);
+		vec2 cellScale = float(gridSize) / max(hi - lo, vec2(1e-20f));
+		auto cellOf = [&](vec2 p) { return clamp(ivec2((p - lo) * cellScale), ivec2(0), ivec2(gridSize - 1)); };
+
+		// clip edge j goes into every cell that its bounding box overlaps
+		int m = (int)c.size();
+		cellStart.assign(gridSize * gridSize + 1, 0);
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (int j = 0; j < m; j++)
+			{
+				vec2 a = c[j], b = c[(j + 1) % m];
+				ivec2 cLo = cellOf(min(a, b)), cHi = cellOf(max(a, b));
+				for (int y = cLo.y; y <= cHi.y; y++)
+					for (int x = cLo.x; x <= cHi.x; x++)
+					{
+						if (pass == 0) cellStart[y * gridSize + x + 1]++;
+						else cellEdges[stamp[y * gridSize + x]++] = j;
+					}
+			}
+			if (pass == 0)
+			{
+				for (int k = 0; k < gridSize * gridSize; k++) cellStart[k + 1] += cellStart[k];
+				cellEdges.resize(cellStart.back());
+				stamp.assign(cellStart.begin(), cellStart.end() - 1); // fill positions
+			}
+		}
+
+		stamp.assign(m, -1); // last subject edge tested against each clip edge
+		int n = (int)s.size();
+		for (int i = 0; i < n; i++)
+		{
+			vec2 s0 = s[i], s1 = s[(i + 1) % n];
+			vec2 eLo = min(s0, s1), eHi = max(s0, s1);
+			if (eHi.x < lo.x || eHi.y < lo.y || eLo.x > hi.x || eLo.y > hi.y) continue;
+			ivec2 cLo = cellOf(eLo), cHi = cellOf(eHi);
+			for (int y = cLo.y; y <= cHi.y; y++)
+				for (int x = cLo.x; x <= cHi.x; x++)
+					for (int k = cellStart[y * gridSize + x]; k < cellStart[y * gridSize + x + 1]; k++)
+					{
+						int j = cellEdges[k];
+						if (stamp[j] == i) continue;
+						stamp[j] = i;
+
+						vec2 c0 = c[j], c1 = c[(j + 1) % m];
+						SegmentRelation relation = intersectSegments(s0, s1, c0, c1);
+						if (relation == SEGMENTS_DISJOINT) continue;
+						if (relation != SEGMENTS_CROSS) return false; // through a vertex or overlapping
+
+						dvec2 ds = dvec2(s1) - dvec2(s0), dc = dvec2(c1) - dvec2(c0), dsc = dvec2(c0) - dvec2(s0);
+						double d = Cross(ds, dc);
+						double sAlpha = Cross(dsc, dc) / d, cAlpha = Cross(dsc, ds) / d;
+						hits.push_back({ i, j, sAlpha, cAlpha, vec2(dvec2(s0) + sAlpha * ds) });
+					}
+		}
+		return true;
+	}
+
+	// vertex list of a polygon with the intersections inserted by their position along the edges;
+	// hitNode gets the node of each hit
+	int BuildList(const std::vector<vec2>& v, bool subject, std::vector<int>& hitNode)
+	{
+		std::vector<int> order(hits.size());
+		for (int h = 0; h < (int)hits.size(); h++) order[h] = h;
+		std::sort(order.begin(), order.end(), [&](int a, int b) {
+			const Hit& ha = hits[a], & hb = hits[b];
+			int ea = subject ? ha.s : ha.c, eb = subject ? hb.s : hb.c;
+			double aa = subject ? ha.sAlpha : ha.cAlpha, ab = subject ? hb.sAlpha : hb.cAlpha;
+			return ea < eb || (ea == eb && aa < ab);
+		});
+
+		int first = (int)nodes.size();
+		size_t h = 0;
+		for (int i = 0; i < (int)v.size(); i++)
+		{
+			nodes.push_back({ v[i] });
+			for (; h < order.size() && (subject ? hits[order[h]].s : hits[order[h]].c) == i; h++)
+			{
+				hitNode[order[h]] = (int)nodes.size();
+				nodes.push_back({ hits[order[h]].p });
+			}
+		}
+		int last = (int)nodes.size() - 1;
+		for (int k = first; k <= last; k++)
+		{
+			nodes[k].next = k == last ? first : k + 1;
+			nodes[k].prev = k == first ? last : k - 1;
+		}
+		return first;
+	}
+
+	// entry: the list enters the other polygon at the intersection; the walk starts at a vertex that is
+	// strictly inside or outside of the other polygon
+	void MarkEntries(int first, const std::vector<vec2>& other, bool invert)
+	{
+		int start = first, location = 0;
+		do
+		{
+			if (nodes[start].neighbor < 0 && (location = Locate(other, nodes[start].p)) != 0) break;
+			start = nodes[start].next;
+		} while (start != first);
+
+		bool inside = location > 0;
+		int k = start;
+		do
+		{
+			if (nodes[k].neighbor >= 0)
+			{
+				nodes[k].entry = !inside != invert;
+				inside = !inside;
+			}
+			k = nodes[k].next;
+		} while (k != start);
+	}
+
+	// rings with positive area are boundaries, the negative ones are holes in the smallest boundary around them
+	std::vector<Region> Assemble(std::vector<std::vector<vec2>>& rings)
+	{
+		std::vector<Region> regions;
+		std::vector<double> areas;
+		std::vector<vec4> boxes;
+		for (auto& ring : rings)
+		{
+			double area = ring.size() >= 3 ? SignedArea(ring) : 0.0;
+			if (area <= 0.0) continue;
+			vec2 lo = ring[0], hi = ring[0];
+			for (vec2 p : ring) { lo = min(lo, p); hi = max(hi, p); }
+			areas.push_back(area);
+			boxes.push_back(vec4(lo, hi));
+			regions.push_back({ std::move(ring) });
+		}
+		// a hole in a single bounding box needs no test, the others are located in the candidate boundaries in batches
+		std::vector<std::vector<vec2>*> holes;
+		std::vector<vec2> probes;
+		for (auto& ring : rings)
+			if (ring.size() >= 3 && SignedArea(ring) < 0.0)
+			{
+				holes.push_back(&ring);
+				probes.push_back((ring[0] + ring[1]) * 0.5f);
+			}
+		std::vector<int> owner(holes.size(), -1);
+		std::vector<std::vector<int>> tests(regions.size());
+		for (size_t h = 0; h < holes.size(); h++)
+		{
+			vec2 probe = probes[h];
+			int candidates = 0, last = -1;
+			for (int r = 0; r < (int)regions.size(); r++)
+				if (probe.x >= boxes[r].x && probe.y >= boxes[r].y && probe.x <= boxes[r].z && probe.y <= boxes[r].w)
+				{
+					if (last >= 0) tests[last].push_back((int)h);
+					candidates++;
+					last = r;
+				}
+			if (candidates == 1) owner[h] = last;
+			else if (candidates > 1) tests[last].push_back((int)h);
+		}
+		std::vector<vec2> points;
+		std::vector<char> inside;
+		for (size_t r = 0; r < regions.size(); r++)
+		{
+			if (tests[r].empty()) continue;
+			locator.Build(regions[r].outer);
+			points.clear();
+			for (int h : tests[r]) points.push_back(probes[h]);
+			locator.Inside(points, inside);
+			for (size_t i = 0; i < points.size(); i++)
+			{
+				int h = tests[r][i];
+				if (inside[i] && (owner[h] < 0 || areas[r] < areas[owner[h]])) owner[h] = (int)r;
+			}
+		}
+		for (size_t h = 0; h < holes.size(); h++)
+			if (owner[h] >= 0) regions[owner[h]].holes.push_back(std::move(*holes[h]));
+		return regions;
+	}
+
+public:
+	std::vector<Region> Clip(std::vector<vec2> subject, std::vector<vec2> clip, Operation op)
+	{
+		if (subject.size() < 3 || clip.size() < 3) return {};
+		if (SignedArea(subject) < 0.0) std::reverse(subject.begin(), subject.end());
+		if (SignedArea(clip) < 0.0) std::reverse(clip.begin(), clip.end());
+
+		// move the clip polygon by a growing tiny amount until it is in general position
+		vec2 lo = clip[0], hi = clip[0];
+		for (vec2 p : clip) { lo = min(lo, p); hi = max(hi, p); }
+		float shift = 1e-6f * max(max(hi.x - lo.x, hi.y - lo.y), 1e-3f);
+		bool general = FindIntersections(subject, clip);
+		for (int attempt = 0; !general && attempt < 8; attempt++, shift *= 4.0f)
+		{
+			for (size_t i = 0; i < clip.size(); i++)
+				clip[i] += shift * vec2(cosf(3.0f * i + attempt), sinf(5.0f * i + attempt));
+			general = FindIntersections(subject, clip);
+		}
+		if (!general) return {}; // still degenerate: the intersection list is incomplete and cannot be traced
+
+		if (hits.empty())
+		{
+			bool subjectInClip = Locate(clip, subject[0]) > 0, clipInSubject = Locate(subject, clip[0]) > 0;
+			switch (op)
+			{
+			case INTERSECTION:
+				if (subjectInClip) return { { subject } };
+				if (clipInSubject) return { { clip } };
+				return {};
+			case UNION:
+				if (subjectInClip) return { { clip } };
+				if (clipInSubject) return { { subject } };
+				return { { subject }, { clip } };
+			default:
+				if (subjectInClip) return {};
+				if (clipInSubject) return { { subject, { clip } } };
+				return { { subject } };
+			}
+		}
+
+		nodes.clear();
+		std::vector<int> subjectHit(hits.size()), clipHit(hits.size());
+		int subjectFirst = BuildList(subject, true, subjectHit);
+		int clipFirst = BuildList(clip, false, clipHit);
+		for (size_t h = 0; h < hits.size(); h++)
+		{
+			nodes[subjectHit[h]].neighbor = clipHit[h];
+			nodes[clipHit[h]].neighbor = subjectHit[h];
+		}
+		MarkEntries(subjectFirst, clip, op != INTERSECTION);
+		MarkEntries(clipFirst, subject, op == UNION);
+
+		// trace: forward from an entry, backward from an exit, switching lists at every intersection;
+		// starting from subject entries keeps the result on the left, boundaries counterclockwise and holes clockwise
+		std::vector<std::vector<vec2>> rings;
+		for (size_t h = 0; h < hits.size(); h++)
+		{
+			int k = subjectHit[h];
+			if (nodes[k].visited || !nodes[k].entry) continue;
+			std::vector<vec2> ring = { nodes[k].p };
+			do
+			{
+				nodes[k].visited = nodes[nodes[k].neighbor].visited = true;
+				bool forward = nodes[k].entry;
+				do
+				{
+					k = forward ? nodes[k].next : nodes[k].prev;
+					ring.push_back(nodes[k].p);
+				} while (nodes[k].neighbor < 0);
+				k = nodes[k].neighbor;
+			} while (!nodes[k].visited);
+			ring.pop_back(); // the starting point again
+			rings.push_back(std::move(ring));
+		}
+		return Assemble(rings);
+	}
+};
+
+// randomized self-check of the boolean operations: area(I) + area(U) = area(S) + area(C) and
+// area(D) = area(S) - area(I); the vertices are on a 1/8 grid, so shared vertices, vertices on edges
+// and overlapping edges are frequent; returns the number of failures
+int CheckBooleanAreas(int nTrials, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	auto snap = [](vec2 p) { return round(p * 8.0f) / 8.0f; };
+
+	// counterclockwise around a grid point, every vertex strictly turning left around it keeps the polygon simple
+	auto randomPolygon = [&]() {
+		while (true)
+		{
+			vec2 center = snap(vec2(uniform(rng), uniform(rng)) - 0.5f);
+			std::vector<vec2> ring;
+			if (rng() % 3 == 0) // rectangle
+			{
+				vec2 half = vec2(1 + rng() % 5, 1 + rng() % 5) / 8.0f;
+				ring = { center - half, center + vec2(half.x, -half.y), center + half, center + vec2(-half.x, half.y) };
+			}
+			else
+			{
+				int n = 3 + rng() % 10;
+				for (int i = 0; i < n; i++)
+				{
+					float a = 2 * (float)M_PI * (i + 0.5f * uniform(rng)) / n, r = 0.125f + 0.625f * uniform(rng);
+					ring.push_back(snap(center + r * vec2(cosf(a), sinf(a))));
+				}
+			}
+			bool simple = true;
+			for (size_t i = 0; i < ring.size() && simple; i++)
+				simple = orient2D(center, ring[i], ring[(i + 1) % ring.size()]) > 0;
+			if (simple) return ring;
+		}
+	};
+	auto ringArea = [](const std::vector<vec2>& v) {
+		double area = 0.0;
+		for (size_t i = 0, j = v.size() - 1; i < v.size(); j = i++) area += (double)v[j].x * v[i].y - (double)v[j].y * v[i].x;
+		return area / 2.0;
+	};
+	auto regionsArea = [&](const std::vector<BooleanClipper::Region>& regions) {
+		double area = 0.0;
+		for (const BooleanClipper::Region& region : regions)
+		{
+			area += fabs(ringArea(region.outer));
+			for (const auto& hole : region.holes) area -= fabs(ringArea(hole));
+		}
+		return area;
+	};
+
+	BooleanClipper clipper;
+	int failures = 0;
+	for (int trial = 0; trial < nTrials; trial++)
+	{
+		std::vector<vec2> subject = randomPolygon(), clip = randomPolygon();
+		double s = ringArea(subject), c = ringArea(clip);
+		double i = regionsArea(clipper.Clip(subject, clip, BooleanClipper::INTERSECTION));
+		double u = regionsArea(clipper.Clip(subject, clip, BooleanClipper::UNION));
+		double d = regionsArea(clipper.Clip(subject, clip, BooleanClipper::DIFFERENCE));
+		double tolerance = 1e-4 * (s + c); // the clip polygon may be moved off the degenerate position a little
+		if ((fabs(i + u - s - c) > tolerance || fabs(d - (s - i)) > tolerance) && failures++ == 0)
+			printf("first failure: trial %d, %d and %d vertices, areas S %g C %g I %g U %g D %g\n", trial,
+				(int)subject.size(), (int)clip.size(), s, c, i, u, d);
+	}
+	return failures;
+}
+
 class SutherlandHodgman : public glApp
 {
 	std::vector<std::pair<Geometry<vec2>*, Geometry<vec2>*>> shapes;
 	Geometry<vec2>* window;
 	GPUProgram* gpuProgram;
+	EarClipper earClipper;
+	MonotoneTriangulator monotoneTriangulator;
+	Triangulator* triangulator = &earClipper;
+	PolygonClipper clipper;
+	std::vector<PolygonClipper::Polygon> clipInput;	// reused between the frames
+	std::vector<vec2> clipOutput, polygon;
+	std::vector<int> clipStarts;
+	BooleanClipper booleanClipper;
+	BooleanClipper::Operation operation = BooleanClipper::INTERSECTION;
+	bool concaveWindow = false;
 
 	const float epsilon = 1e-5f;
+	int lastX = 0, lastY = 0;
 
 public:
 	SutherlandHodgman() : glApp("Sutherland-Hodgman Polygon Clipping") {}
@@ -97,8 +647,51 @@ public:
 		window->Draw(gpuProgram, GL_LINE_LOOP, vec3(1.0f, 1.0f, 1.0f));
 	}
 
+	// m: ear clipping / monotone partition, s: 1000 more small stars,
+	// w: rectangle / star window, o: intersection / union / difference, t: self-check of the boolean operations
+	void onKeyboard(int key)
+	{
+		if (key == 't')
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			int failures = CheckBooleanAreas(20000, 42);
+			auto end = std::chrono::high_resolution_clock::now();
+			printf("boolean operations self-check: 20000 polygon pairs, %d failures, %.1f ms\n", failures,
+				std::chrono::duration<float, std::milli>(end - start).count());
+			return;
+		}
+		if (key == 'w')
+		{
+			concaveWindow = !concaveWindow;
+			RecalculateWindow(lastX, lastY);
+		}
+		else if (key == 'o')
+			operation = (BooleanClipper::Operation)((operation + 1) % 3);
+		else if (key == 'm')
+			triangulator = triangulator == &earClipper ? (Triangulator*)&monotoneTriangulator : &earClipper;
+		else if (key == 's')
+		{
+			for (int i = 0; i < 1000; i++)
+			{
+				auto* star = new Geometry<vec2>;
+				star->Vtx() = GenerateStarVertices(vec2(rand() % 200 / 100.0f - 1.0f, rand() % 200 / 100.0f - 1.0f), 0.02f + rand() % 100 / 100.0f * 0.04f);
+				star->updateGPU();
+				shapes.push_back({ star, new Geometry<vec2> });
+			}
+		}
+		else return;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		RecalculateClippedShapes();
+		auto end = std::chrono::high_resolution_clock::now();
+		printf("%d shapes clipped and triangulated: %.3f ms\n", (int)shapes.size(), std::chrono::duration<float, std::milli>(end - start).count());
+		refreshScreen();
+	}
+
 	void onMouseMotion(int pX, int pY)
 	{
+		lastX = pX;
+		lastY = pY;
 		RecalculateWindow(pX, pY);
 		RecalculateClippedShapes();
 		refreshScreen();
@@ -110,6 +703,15 @@ public:
 		static const float hHalf = 0.3f;
 
 		vec2 p = ScreenToNDC(pX, pY);
+		if (concaveWindow)
+		{
+			// skip the center and the duplicate last vertex
+			window->Vtx() = GenerateStarVertices(p, wHalf);
+			window->Vtx().erase(window->Vtx().begin());
+			window->Vtx().pop_back();
+			window->updateGPU();
+			return;
+		}
 		window->Vtx() = {
 			vec2(p.x - wHalf, p.y - hHalf),
 			vec2(p.x + wHalf, p.y - hHalf),
@@ -121,50 +723,57 @@ public:
 
 	void RecalculateClippedShapes()
 	{
-		for (auto& [shape, clippedShape] : shapes)
+		if (concaveWindow || operation != BooleanClipper::INTERSECTION)
 		{
-			// copy the vertices, but skip the center and the first (duplicate) vertex
-			clippedShape->Vtx().assign(shape->Vtx().begin() + 2, shape->Vtx().end());
+			RecalculateBooleanShapes();
+			return;
+		}
 
-			// clip with the window sides
-			clippedShape->Vtx() = SutherlandHodgmanPolygonClipping(clippedShape->Vtx(), window->Vtx()[0], vec2(0.0f, 1.0f));
-			clippedShape->Vtx() = SutherlandHodgmanPolygonClipping(clippedShape->Vtx(), window->Vtx()[1], vec2(-1.0f, 0.0f));
-			clippedShape->Vtx() = SutherlandHodgmanPolygonClipping(clippedShape->Vtx(), window->Vtx()[2], vec2(0.0f, -1.0f));
-			clippedShape->Vtx() = SutherlandHodgmanPolygonClipping(clippedShape->Vtx(), window->Vtx()[3], vec2(1.0f, 0.0f));
+		// clip with the window sides, all the shapes in one batch
+		const std::vector<vec2>& w = window->Vtx();
+		PolygonClipper::Plane planes[4] = { { w[0], vec2(0.0f, 1.0f) }, { w[1], vec2(-1.0f, 0.0f) }, { w[2], vec2(0.0f, -1.0f) }, { w[3], vec2(1.0f, 0.0f) } };
+		clipper.SetPlanes(planes, 4);
 
-			// triangulate the clipped shape
+		// skip the center and the first (duplicate) vertex
+		clipInput.clear();
+		for (auto& [shape, clippedShape] : shapes)
+			clipInput.push_back({ shape->Vtx().data() + 2, (int)shape->Vtx().size() - 2 });
+		clipper.ClipBatch(clipInput, clipOutput, clipStarts);
+
+		// triangulate the clipped shapes
+		for (size_t s = 0; s < shapes.size(); s++)
+		{
+			Geometry<vec2>* clippedShape = shapes[s].second;
+			clippedShape->Vtx().clear();
+			polygon.assign(clipOutput.begin() + clipStarts[s], clipOutput.begin() + clipStarts[s + 1]);
+			if (polygon.empty()) continue;
+
+			for (unsigned int i : triangulator->Triangulate(polygon))
+				clippedShape->Vtx().push_back(polygon[i]);
 			if (!clippedShape->Vtx().empty())
-			{
-				clippedShape->Vtx() = Triangulate(clippedShape->Vtx());
-				if (!clippedShape->Vtx().empty())
-					clippedShape->updateGPU();
-			}
+				clippedShape->updateGPU();
 		}
 	}
 
-	std::vector<vec2> SutherlandHodgmanPolygonClipping(const std::vector<vec2>& p, const vec2& p0, const vec2& n) // vertices, clip line's start point and normal vector
+	// general clipping against any window, the result regions (with holes) go to the triangulator
+	void RecalculateBooleanShapes()
 	{
-		std::vector<vec2> q;
-		for (int i = 0; i < p.size(); i++)
+		for (auto& [shape, clippedShape] : shapes)
 		{
-			int nI = (i + 1) % p.size();
-			if (dot(p[i] - p0, n) >= 0.0f) // vertex is in the polygon
+			clippedShape->Vtx().clear();
+			polygon.assign(shape->Vtx().begin() + 2, shape->Vtx().end());
+			for (const BooleanClipper::Region& region : booleanClipper.Clip(polygon, window->Vtx(), operation))
 			{
-				q.push_back(p[i]);
-				if (dot(p[nI] - p0, n) < 0.0f) // next vertex is outside the polygon
-					q.push_back(Intersect(p[i], p[nI], p0, n));
+				// the indices go over the outer vertices, then the hole vertices
+				clipOutput = region.outer;
+				for (const auto& hole : region.holes)
+					clipOutput.insert(clipOutput.end(), hole.begin(), hole.end());
+				for (unsigned int i : triangulator->Triangulate(region.outer, region.holes))
+					clippedShape->Vtx().push_back(clipOutput[i]);
 			}
-			else if (dot(p[nI] - p0, n) >= 0.0f) // next vertex is in the polygon
-				q.push_back(Intersect(p[i], p[nI], p0, n));
+			if (!clippedShape->Vtx().empty())
+				clippedShape->updateGPU();
 		}
-		return q;
-	}
-
-	vec2 Intersect(const vec2& p1, const vec2& p2, const vec2& p0, const vec2& n)
-	{
-		vec2 d = p2 - p1;
-		float t = dot(p0 - p1, n) / dot(d, n);
-		return p1 + t * d;
 	}
 
 	std::vector<vec2> GenerateStarVertices(const vec2& c, float r)
@@ -185,95 +794,6 @@ public:
 		return vertices;
 	}
 
-	std::vector<vec2> Triangulate(const std::vector<vec2>& v)
-	{
-		std::vector<vec2> vertices = v;
-		std::vector<vec2> triangles;
-		triangles.reserve((vertices.size() - 2) * 3);
-
-		while (vertices.size() >= 3)
-		{
-			int vIdx = FindEar(vertices);
-			if (vIdx == -1) break;
-
-			// add new triangle
-			int prevIdx = (vIdx - 1 + vertices.size()) % vertices.size();
-			int nextIdx = (vIdx + 1) % vertices.size();
-			triangles.push_back(vertices[prevIdx]);
-			triangles.push_back(vertices[vIdx]);
-			triangles.push_back(vertices[nextIdx]);
-
-			// remove the ear vertex
-			vertices.erase(vertices.begin() + vIdx);
-		}
-
-		return triangles;
-	}
-
-	int FindEar(const std::vector<vec2>& v)
-	{
-		if (v.size() < 3) return -1;
-
-		int diagIdx = -1;
-		for (int i = 0; i < v.size(); i++)
-		{
-			diagIdx = i;
-			int prevIdx = (i - 1 + v.size()) % v.size();
-			int nextIdx = (i + 1) % v.size();
-
-			// search for edge intersections (enough vertices are needed)
-			if (v.size() > 4)
-			{
-				for (int j = 0; j < v.size() - 4; j++)
-				{
-					// edge indices
-					int i1 = (i - 2 - j + v.size()) % v.size();
-					int i2 = (i - 3 - j + v.size()) % v.size();
-					if (LineIntersect(v[prevIdx], v[nextIdx], v[i1], v[i2]))
-					{
-						diagIdx = -1; // edge intersection found
-						break;
-					}
-				}
-			}
-
-			// not a diagonal
-			if (diagIdx == -1) continue;
-
-			// triangle is always an ear
-			if (v.size() == 3) return diagIdx;
-
-			// calculate the maximum x coord for the half line
-			float xMax = v[0].x;
-			for (int j = 1; j < v.size(); j++)
-				if (v[j].x > xMax)
-					xMax = v[j].x;
-			xMax += 0.01f; // to avoid precision issues
-
-			// see if it goes fully outside of the polygon
-			vec2 halfPoint = (v[prevIdx] + v[nextIdx]) * 0.5f;
-			int c = 0;
-			for (int j = 0; j < v.size(); j++)
-				if (LineIntersect(halfPoint, { xMax, halfPoint.y }, v[j], v[(j + 1) % v.size()]))
-					c++;
-
-			if (c % 2 == 1) return diagIdx;
-		}
-
-		return -1;
-	}
-
-	bool LineIntersect(const vec2& l1, const vec2& l2, const vec2& r1, const vec2& r2)
-	{
-		vec2 ln = l2 - l1; ln = vec2(-ln.y, ln.x);
-		if (dot(ln, (r1 - l1)) * dot(ln, (r2 - l1)) > 0) return false;
-
-		vec2 rn = r2 - r1; rn = vec2(-rn.y, rn.x);
-		if (dot(rn, (l1 - r1)) * dot(rn, (l2 - r1)) > 0) return false;
-
-		return true;
-	}
-
 	vec2 ScreenToNDC(int pX, int pY)
 	{
 		float x = (2.0f * pX / winWidth) - 1.0f;
@@ -77,6 +77,88 @@ bool pollKey(int key) {
 	return (glfwGetKey(window, key) == GLFW_PRESS);
 }
 
+// Exact geometric predicates
+// x + y = a + b exactly
+static void twoSum(double a, double b, double& x, double& y) {
+	x = a + b;
+	double bVirtual = x - a;
+	y = (a - (x - bVirtual)) + (b - bVirtual);
+}
+
+// x + y = a * b exactly
+static void twoProduct(double a, double b, double& x, double& y) {
+	x = a * b;
+	y = fma(a, b, -x);
+}
+
+// e += b in place; an expansion has nonoverlapping components with increasing magnitude, no zeros
+static int growExpansion(double* e, int n, double b) {
+	int m = 0;
+	for (int i = 0; i < n; i++) {
+		double sum, err;
+		twoSum(b, e[i], sum, err);
+		if (err != 0.0) e[m++] = err;
+		b = sum;
+	}
+	if (b != 0.0) e[m++] = b;
+	return m;
+}
+
+// h += e * b
+static int addScaledExpansion(double* h, int nh, const double* e, int n, double b) {
+	for (int i = 0; i < n; i++) {
+		double product, err;
+		twoProduct(e[i], b, product, err);
+		nh = growExpansion(h, nh, err);
+		nh = growExpansion(h, nh, product);
+	}
+	return nh;
+}
+
+static int expansionSign(const double* e, int n) { return n == 0 ? 0 : (e[n - 1] > 0.0 ? 1 : -1); } // the largest component decides
+
+// the products of floats are exact in double, so the orientation is a sum of six exact terms
+static int orient2DExpansion(vec2 a, vec2 b, vec2 c, double* e) {
+	double terms[6] = { (double)a.x * b.y, -(double)a.x * c.y, (double)b.x * c.y,
+						-(double)b.x * a.y, (double)c.x * a.y, -(double)c.x * b.y };
+	int n = 0;
+	for (double t : terms) n = growExpansion(e, n, t);
+	return n;
+}
+
+int orient2DExact(vec2 a, vec2 b, vec2 c) {
+	double e[6];
+	return expansionSign(e, orient2DExpansion(a, b, c, e));
+}
+
+// the 4x4 determinant of the lifted points (x, y, x^2 + y^2, 1) by the lift column:
+// the lifts are exact as two doubles, the minors are exact orientations
+int inCircleExact(vec2 a, vec2 b, vec2 c, vec2 d) {
+	const vec2 p[4] = { a, b, c, d };
+	double h[96];
+	int nh = 0;
+	for (int i = 0; i < 4; i++) {
+		double minor[6];
+		int nMinor = orient2DExpansion(p[i == 0 ? 1 : 0], p[i <= 1 ? 2 : 1], p[i <= 2 ? 3 : 2], minor);
+		double lift[2] = { (double)p[i].x * p[i].x, (double)p[i].y * p[i].y };
+		for (double l : lift) nh = addScaledExpansion(h, nh, minor, nMinor, i % 2 == 0 ? l : -l);
+	}
+	return expansionSign(h, nh);
+}
+
+SegmentRelation intersectSegments(vec2 a, vec2 b, vec2 c, vec2 d) {
+	int o1 = orient2D(a, b, c), o2 = orient2D(a, b, d), o3 = orient2D(c, d, a), o4 = orient2D(c, d, b);
+	if (o1 * o2 < 0 && o3 * o4 < 0) return SEGMENTS_CROSS;
+	if (o1 == 0 && o2 == 0 && o3 == 0 && o4 == 0) {
+		// on a common line: compare the intervals along x, or along y if the line is vertical
+		bool alongX = a.x != b.x || a.x != c.x || a.x != d.x;
+		float lo = alongX ? max(min(a.x, b.x), min(c.x, d.x)) : max(min(a.y, b.y), min(c.y, d.y));
+		float hi = alongX ? min(max(a.x, b.x), max(c.x, d.x)) : min(max(a.y, b.y), max(c.y, d.y));
+		return lo > hi ? SEGMENTS_DISJOINT : lo == hi ? SEGMENTS_TOUCH : SEGMENTS_OVERLAP;
+	}
+	return o1 * o2 <= 0 && o3 * o4 <= 0 ? SEGMENTS_TOUCH : SEGMENTS_DISJOINT;
+}
+
 int main(void) {
 	// Alkalmazi ablak ltrehozsa
 	glfwSetErrorCallback(error_callback);
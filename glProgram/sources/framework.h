@@ -10,8 +10,14 @@
 #include <math.h>
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRAMEWORK_SSE2
+#include <emmintrin.h>
+#endif
 
 #define FILE_OPERATIONS
 #ifdef FILE_OPERATIONS
@@ -103,11 +109,13 @@ class GPUProgram {
 
 public:
 	GPUProgram( ) { }
-	GPUProgram(const char* const vertexShaderSource, const char * const fragmentShaderSource, const char * const geometryShaderSource = nullptr) {
-		create(vertexShaderSource, fragmentShaderSource, geometryShaderSource);
+	GPUProgram(const char* const vertexShaderSource, const char * const fragmentShaderSource, const char * const geometryShaderSource = nullptr,
+			   const char* const tessControlShaderSource = nullptr, const char* const tessEvaluationShaderSource = nullptr) {
+		create(vertexShaderSource, fragmentShaderSource, geometryShaderSource, tessControlShaderSource, tessEvaluationShaderSource);
 	}
 
-	void create(const char* const vertexShaderSource, const char * const fragmentShaderSource, const char * const geometryShaderSource = nullptr) {
+	void create(const char* const vertexShaderSource, const char * const fragmentShaderSource, const char * const geometryShaderSource = nullptr,
+				const char* const tessControlShaderSource = nullptr, const char* const tessEvaluationShaderSource = nullptr) {
 		// Program ltrehozsa a forrs sztringbl
 		GLuint  vertexShader = glCreateShader(GL_VERTEX_SHADER);
 		if (!vertexShader) {
@@ -131,6 +139,22 @@ public:
 			if (!checkShader(geometryShader, "Geometry shader error")) return;
 		}
 
+		// tessellation control and evaluation shaders, if any (OpenGL 4.0)
+		GLuint tessShaders[2] = { 0, 0 };
+		const char* const tessSources[2] = { tessControlShaderSource, tessEvaluationShaderSource };
+		const GLenum tessTypes[2] = { GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER };
+		for (int i = 0; i < 2; i++) {
+			if (tessSources[i] == nullptr) continue;
+			tessShaders[i] = glCreateShader(tessTypes[i]);
+			if (!tessShaders[i]) {
+				printf("Error in %s shader creation\n", shaderType2string(tessTypes[i]).c_str());
+				exit(1);
+			}
+			glShaderSource(tessShaders[i], 1, (const GLchar**)&tessSources[i], NULL);
+			glCompileShader(tessShaders[i]);
+			if (!checkShader(tessShaders[i], shaderType2string(tessTypes[i]) + " shader error")) return;
+		}
+
 		// Program ltrehozsa a forrs sztringbl
 		GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 		if (!fragmentShader) {
@@ -150,6 +174,7 @@ public:
 		glAttachShader(shaderProgramId, vertexShader);
 		glAttachShader(shaderProgramId, fragmentShader);
 		if (geometryShader > 0) glAttachShader(shaderProgramId, geometryShader);
+		for (GLuint tessShader : tessShaders) if (tessShader > 0) glAttachShader(shaderProgramId, tessShader);
 
 		// Szerkeszts
 		if (!link()) return;
@@ -234,9 +259,10 @@ public:
 template<class T>
 class Geometry {
 //---------------------------
-	unsigned int vao, vbo;	// GPU
+	unsigned int vao, vbo, ibo = 0;	// GPU
 protected:
 	std::vector<T> vtx;	// CPU
+	std::vector<unsigned int> idx;	// CPU, optional: if not empty, Draw takes the vertices in this order
 public:
 	Geometry() {
 		glGenVertexArrays(1, &vao);
@@ -248,24 +274,93 @@ public:
 		glVertexAttribPointer(0, nf, GL_FLOAT, GL_FALSE, 0, NULL);
 	}
 	std::vector<T>& Vtx() { return vtx; }
+	std::vector<unsigned int>& Idx() { return idx; }
 	void updateGPU() {	// CPU -> GPU
 		glBindBuffer(GL_ARRAY_BUFFER, vbo);
 		glBufferData(GL_ARRAY_BUFFER, vtx.size() * sizeof(T), &vtx[0], GL_DYNAMIC_DRAW);
+		if (idx.size() > 0) {
+			glBindVertexArray(vao); // the index buffer binding is part of the vao
+			if (ibo == 0) glGenBuffers(1, &ibo);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, idx.size() * sizeof(unsigned int), &idx[0], GL_DYNAMIC_DRAW);
+		}
+	}
+	void updateGPU(int first, int count) {	// CPU -> GPU, only vtx[first, first + count) into the buffer of the last full update
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(T), count * sizeof(T), &vtx[first]);
 	}
 	void Bind() { glBindVertexArray(vao); glBindBuffer(GL_ARRAY_BUFFER, vbo); } // aktivls
 	void Draw(GPUProgram* prog, int type, vec3 color) {
 		if (vtx.size() > 0) {
 			prog->setUniform(color, "color");
 			glBindVertexArray(vao);
-			glDrawArrays(type, 0, (int)vtx.size());
+			if (idx.size() > 0) glDrawElements(type, (int)idx.size(), GL_UNSIGNED_INT, NULL);
+			else glDrawArrays(type, 0, (int)vtx.size());
+		}
+	}
+	void Draw(GPUProgram* prog, int type, vec3 color, int first, int count) {	// only idx[first, first + count)
+		prog->setUniform(color, "color");
+		glBindVertexArray(vao);
+		glDrawElements(type, count, GL_UNSIGNED_INT, (const void*)(first * sizeof(unsigned int)));
+	}
+	static constexpr unsigned int restartIndex = 0xFFFFFFFF;	// ends a strip in idx
+	void GridStrips(int N, int M) {	// idx: N triangle strips over the (N + 1) x (M + 1) vertices of a row major grid
+		idx.clear();
+		idx.reserve(N * (2 * (M + 1) + 1));
+		for (int i = 0; i < N; i++) {
+			if (i > 0) idx.push_back(restartIndex);
+			for (int j = 0; j <= M; j++) {
+				idx.push_back(i * (M + 1) + j);
+				idx.push_back((i + 1) * (M + 1) + j);
+			}
 		}
 	}
+	void DrawStrips() {	// every strip of idx with one draw call
+		glBindVertexArray(vao);
+		glEnable(GL_PRIMITIVE_RESTART);
+		glPrimitiveRestartIndex(restartIndex);
+		glDrawElements(GL_TRIANGLE_STRIP, (int)idx.size(), GL_UNSIGNED_INT, NULL);
+		glDisable(GL_PRIMITIVE_RESTART);
+	}
 	virtual ~Geometry() {
+		if (ibo != 0) glDeleteBuffers(1, &ibo);
 		glDeleteBuffers(1, &vbo);
 		glDeleteVertexArrays(1, &vao);
 	}
 };
 
+//---------------------------
+class TextureBuffer {
+//---------------------------
+	// a buffer of vec4s read by texelFetch from a samplerBuffer in any shader
+	unsigned int bufferId = 0, textureId = 0;
+	size_t capacity = 0;
+public:
+	TextureBuffer() {
+		glGenBuffers(1, &bufferId);
+		glGenTextures(1, &textureId);
+		glBindBuffer(GL_TEXTURE_BUFFER, bufferId);
+		glBindTexture(GL_TEXTURE_BUFFER, textureId);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, bufferId);
+	}
+	void updateGPU(const std::vector<vec4>& data) {	// CPU -> GPU, reallocated only when it grows
+		glBindBuffer(GL_TEXTURE_BUFFER, bufferId);
+		if (data.size() > capacity) {
+			capacity = max(data.size(), 2 * capacity);
+			glBufferData(GL_TEXTURE_BUFFER, capacity * sizeof(vec4), NULL, GL_DYNAMIC_DRAW);
+		}
+		if (data.size() > 0) glBufferSubData(GL_TEXTURE_BUFFER, 0, data.size() * sizeof(vec4), &data[0]);
+	}
+	void Bind(int textureUnit) {
+		glActiveTexture(GL_TEXTURE0 + textureUnit);
+		glBindTexture(GL_TEXTURE_BUFFER, textureId);
+	}
+	~TextureBuffer() {
+		glDeleteTextures(1, &textureId);
+		glDeleteBuffers(1, &bufferId);
+	}
+};
+
 //---------------------------
 class Texture {
 //---------------------------
@@ -331,6 +426,238 @@ public:
 	}
 };
 
+enum PixelFormat { PIXEL_RGBA8, PIXEL_RGB10A2, PIXEL_RGBA16F };
+enum PixelLayout { LAYOUT_LINEAR, LAYOUT_TILED }; // tiled: 8x8 tiles, Morton order inside a tile
+
+//---------------------------
+class PixelBuffer {
+//---------------------------
+	// CPU side image of the software rendered demos, stored packed in the texture format, so
+	// the upload needs no format conversion. The tiled layout keeps the pixels of an 8x8 block
+	// of the rasterizer close together; it is copied to a linear staging buffer before upload.
+	int width, height, tilesX;
+	PixelFormat format;
+	PixelLayout layout;
+	int bytesPerPixel;
+	std::vector<unsigned char> pixels;
+	std::vector<unsigned char> staging;
+
+	static unsigned int Morton8(int x, int y) { // interleave the lowest 3 bits, x first
+		return (x & 1) | ((y & 1) << 1) | ((x & 2) << 1) | ((y & 2) << 2) | ((x & 4) << 2) | ((y & 4) << 3);
+	}
+
+	// copy one 8x8 tile to the linear staging buffer, 2x2 quads at once
+	void DetileTile(int tx, int ty) {
+		const unsigned char* src = &pixels[(size_t)(ty * tilesX + tx) * 64 * bytesPerPixel];
+		size_t rowBytes = (size_t)tilesX * 8 * bytesPerPixel;
+		for (int q = 0; q < 16; q++) {
+			int x = tx * 8 + 2 * ((q & 1) | ((q >> 1) & 2)), y = ty * 8 + 2 * (((q >> 1) & 1) | ((q >> 2) & 2));
+			unsigned char* row0 = &staging[y * rowBytes + (size_t)x * bytesPerPixel];
+			unsigned char* row1 = row0 + rowBytes;
+			const unsigned char* quad = src + (size_t)q * 4 * bytesPerPixel;
+#ifdef FRAMEWORK_SSE2
+			if (bytesPerPixel == 4) {
+				__m128i v = _mm_loadu_si128((const __m128i*)quad);
+				_mm_storel_epi64((__m128i*)row0, v);
+				_mm_storel_epi64((__m128i*)row1, _mm_unpackhi_epi64(v, v));
+			}
+			else {
+				_mm_storeu_si128((__m128i*)row0, _mm_loadu_si128((const __m128i*)quad));
+				_mm_storeu_si128((__m128i*)row1, _mm_loadu_si128((const __m128i*)(quad + 16)));
+			}
+#else
+			memcpy(row0, quad, 2 * bytesPerPixel);
+			memcpy(row1, quad + 2 * bytesPerPixel, 2 * bytesPerPixel);
+#endif
+		}
+	}
+
+public:
+	PixelBuffer(int _width, int _height, PixelFormat _format = PIXEL_RGBA8, PixelLayout _layout = LAYOUT_LINEAR)
+		: width(_width), height(_height), format(_format), layout(_layout) {
+		bytesPerPixel = (format == PIXEL_RGBA16F) ? 8 : 4;
+		tilesX = (width + 7) / 8;
+		if (layout == LAYOUT_TILED) {
+			pixels.resize((size_t)tilesX * 8 * ((height + 7) / 8) * 8 * bytesPerPixel);
+			staging.resize(pixels.size());
+		}
+		else pixels.resize((size_t)width * height * bytesPerPixel);
+	}
+
+	int Width() const { return width; }
+	int Height() const { return height; }
+
+	size_t Index(int x, int y) const {	// pixel index in the storage
+		if (layout == LAYOUT_LINEAR) return (size_t)y * width + x;
+		return (size_t)((y >> 3) * tilesX + (x >> 3)) * 64 + Morton8(x & 7, y & 7);
+	}
+
+	uint64_t Pack(const vec3& color) const {
+		vec4 c(clamp(color, 0.0f, format == PIXEL_RGBA16F ? 65504.0f : 1.0f), 1.0f);
+		switch (format) {
+		case PIXEL_RGBA8:	return packUnorm4x8(c);
+		case PIXEL_RGB10A2:	return packUnorm3x10_1x2(c);
+		default:			return packHalf4x16(c);
+		}
+	}
+
+	void SetPacked(size_t index, uint64_t packed) { memcpy(&pixels[index * bytesPerPixel], &packed, bytesPerPixel); } // little endian
+	void Set(int x, int y, const vec3& color) { SetPacked(Index(x, y), Pack(color)); }
+	void Fill(const vec3& color) {
+		uint64_t packed = Pack(color);
+		for (size_t i = 0; i < pixels.size() / bytesPerPixel; i++) SetPacked(i, packed);
+	}
+
+	GLint InternalFormat() const { return format == PIXEL_RGBA8 ? GL_RGBA8 : format == PIXEL_RGB10A2 ? GL_RGB10_A2 : GL_RGBA16F; }
+	GLenum Type() const { return format == PIXEL_RGBA8 ? GL_UNSIGNED_BYTE : format == PIXEL_RGB10A2 ? GL_UNSIGNED_INT_2_10_10_10_REV : GL_HALF_FLOAT; }
+
+	// upload the rectangle [x0, x0 + w) x [y0, y0 + h), or everything, to the bound GL_TEXTURE_2D
+	void Upload(bool allocate = false) { Upload(0, 0, width, height, allocate); }
+	void Upload(int x0, int y0, int w, int h, bool allocate = false) {
+		const unsigned char* linear = pixels.data();
+		int rowLength = width;
+		if (layout == LAYOUT_TILED) {
+			for (int ty = y0 / 8; ty <= (y0 + h - 1) / 8; ty++)
+				for (int tx = x0 / 8; tx <= (x0 + w - 1) / 8; tx++)
+					DetileTile(tx, ty);
+			linear = staging.data();
+			rowLength = tilesX * 8;
+		}
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
+		if (allocate)
+			glTexImage2D(GL_TEXTURE_2D, 0, InternalFormat(), width, height, 0, GL_RGBA, Type(), linear);
+		else
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, w, h, GL_RGBA, Type(), linear + ((size_t)y0 * rowLength + x0) * bytesPerPixel);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+};
+
+// Geometric predicates of float points, exact: the determinant is evaluated in double first, and only
+// when it is within the rounding error bound of zero it is recomputed exactly with expansion arithmetic
+// (sums of nonoverlapping doubles), so almost every call costs a few multiplications only
+int orient2DExact(vec2 a, vec2 b, vec2 c);
+int inCircleExact(vec2 a, vec2 b, vec2 c, vec2 d);
+
+// > 0 if a, b, c turn left, < 0 if they turn right, 0 if collinear
+inline int orient2D(vec2 a, vec2 b, vec2 c) {
+	double detLeft = ((double)b.x - a.x) * ((double)c.y - a.y);
+	double detRight = ((double)b.y - a.y) * ((double)c.x - a.x);
+	double det = detLeft - detRight;
+	double errBound = 3.3306690738754716e-16 * (fabs(detLeft) + fabs(detRight)); // (3 + 16 eps) eps
+	if (fabs(det) > errBound) return (det > 0.0) - (det < 0.0); // a single, well predicted branch
+	return orient2DExact(a, b, c);
+}
+
+// > 0 if d is inside the circle of the counterclockwise a, b, c, < 0 if outside, 0 if on it
+inline int inCircle(vec2 a, vec2 b, vec2 c, vec2 d) {
+	double adx = (double)a.x - d.x, ady = (double)a.y - d.y;
+	double bdx = (double)b.x - d.x, bdy = (double)b.y - d.y;
+	double cdx = (double)c.x - d.x, cdy = (double)c.y - d.y;
+	double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy, aLift = adx * adx + ady * ady;
+	double cdxady = cdx * ady, adxcdy = adx * cdy, bLift = bdx * bdx + bdy * bdy;
+	double adxbdy = adx * bdy, bdxady = bdx * ady, cLift = cdx * cdx + cdy * cdy;
+	double det = aLift * (bdxcdy - cdxbdy) + bLift * (cdxady - adxcdy) + cLift * (adxbdy - bdxady);
+	double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * aLift + (fabs(cdxady) + fabs(adxcdy)) * bLift + (fabs(adxbdy) + fabs(bdxady)) * cLift;
+	double errBound = 1.1102230246251577e-15 * permanent; // (10 + 96 eps) eps
+	if (fabs(det) > errBound) return (det > 0.0) - (det < 0.0);
+	return inCircleExact(a, b, c, d);
+}
+
+enum SegmentRelation { SEGMENTS_DISJOINT, SEGMENTS_CROSS, SEGMENTS_TOUCH, SEGMENTS_OVERLAP }; // touch: one common point, not crossing
+SegmentRelation intersectSegments(vec2 a, vec2 b, vec2 c, vec2 d);
+
+//---------------------------
+class CurveTessellator {
+//---------------------------
+	// Adaptive tessellation of a parametric 2D curve: the parameter range is split into intervals,
+	// always the worst one is halved, until the inner points are within the tolerance of the chords
+	// in pixels, or the vertex budget is spent
+	struct Interval {
+		float t0, t1;
+		vec2 p[5], s[5];	// at t0, the quarters and t1, in world and in pixels
+		float error;		// largest distance of the inner points from the chord in pixels
+		bool operator<(const Interval& i) const { return error < i.error; }
+	};
+	std::vector<Interval> heap, done;
+	float tolerance;
+	int maxVertices, vertexCount = 0, evaluations = 0;
+
+	static float DistanceToChord(vec2 q, vec2 a, vec2 b) {
+		vec2 ab = b - a;
+		float len2 = dot(ab, ab);
+		float t = len2 > 0.0f ? clamp(dot(q - a, ab) / len2, 0.0f, 1.0f) : 0.0f;
+		return length(q - (a + t * ab));
+	}
+	void Push(Interval& iv) {
+		iv.error = 0.0f;
+		for (int i = 1; i < 4; i++) iv.error = max(iv.error, DistanceToChord(iv.s[i], iv.s[0], iv.s[4]));
+		heap.push_back(iv);
+		std::push_heap(heap.begin(), heap.end());
+	}
+public:
+	CurveTessellator(float _tolerance = 0.25f, int _maxVertices = 4096) : tolerance(_tolerance), maxVertices(_maxVertices) {}
+	void setTolerance(float _tolerance) { tolerance = _tolerance; }
+	int VertexCount() const { return vertexCount; }	// of the last tessellation
+	int Evaluations() const { return evaluations; }
+
+	// r(t): world position, toPixels: world -> window pixels; nStart uniform intervals to begin with, so that
+	// no feature smaller than them falls between the test points
+	template<class Curve>
+	void Tessellate(Curve r, float t0, float t1, const mat4& toPixels, std::vector<vec2>& out, int nStart = 16) {
+		auto point = [&](float t, vec2& p, vec2& s) {
+			p = r(t);
+			s = vec2(toPixels * vec4(p.x, p.y, 0.0f, 1.0f));
+			evaluations++;
+		};
+		heap.clear();
+		done.clear();
+		evaluations = 0;
+		nStart = max(1, min(nStart, maxVertices - 1));
+		Interval iv;
+		point(t0, iv.p[4], iv.s[4]);
+		for (int k = 0; k < nStart; k++) {
+			iv.p[0] = iv.p[4]; iv.s[0] = iv.s[4];
+			iv.t0 = t0 + (t1 - t0) * k / nStart;
+			iv.t1 = k == nStart - 1 ? t1 : t0 + (t1 - t0) * (k + 1) / nStart;
+			for (int i = 1; i <= 4; i++) point(iv.t0 + (iv.t1 - iv.t0) * i / 4, iv.p[i], iv.s[i]);
+			Push(iv);
+		}
+
+		vertexCount = nStart + 1;
+		const float minLength = 1e-5f * fabs(t1 - t0);
+		while (!heap.empty() && heap.front().error > tolerance && vertexCount < maxVertices) {
+			std::pop_heap(heap.begin(), heap.end());
+			iv = heap.back();
+			heap.pop_back();
+			if (fabs(iv.t1 - iv.t0) < minLength) { done.push_back(iv); continue; } // a cusp or a jump
+
+			// halves: the quarter points become the midpoints, two new points in each
+			float tm = (iv.t0 + iv.t1) / 2;
+			Interval left, right;
+			left.t0 = iv.t0; left.t1 = tm;
+			right.t0 = tm; right.t1 = iv.t1;
+			for (int i = 0; i < 3; i++) {
+				left.p[2 * i] = iv.p[i]; left.s[2 * i] = iv.s[i];
+				right.p[2 * i] = iv.p[i + 2]; right.s[2 * i] = iv.s[i + 2];
+			}
+			for (int i = 1; i < 4; i += 2) {
+				point(left.t0 + (left.t1 - left.t0) * i / 4, left.p[i], left.s[i]);
+				point(right.t0 + (right.t1 - right.t0) * i / 4, right.p[i], right.s[i]);
+			}
+			Push(left);
+			Push(right);
+			vertexCount++;
+		}
+		done.insert(done.end(), heap.begin(), heap.end());
+
+		std::sort(done.begin(), done.end(), [t0, t1](const Interval& a, const Interval& b) { return t1 >= t0 ? a.t0 < b.t0 : a.t0 > b.t0; });
+		out.clear();
+		out.reserve(done.size() + 1);
+		for (const Interval& d : done) out.push_back(d.p[0]);
+		out.push_back(done.back().p[4]);
+	}
+};
+
 enum MouseButton { MOUSE_LEFT, MOUSE_MIDDLE, MOUSE_RIGHT};
 enum SpecialKeys { KEY_RIGHT = 262, KEY_LEFT = 263, KEY_DOWN = 264, KEY_UP = 265 };
 bool pollKey(int key);
@@ -0,0 +1,181 @@
+//=============================================================================================
+// Point location in simple polygons for batches of inside tests, include after framework.h
+//=============================================================================================
+#pragma once
+#include <algorithm>
+
+//---------------------------
+// Point location in a simple polygon, built once for many queries. The y coordinates of the vertices
+// cut the plane into slabs; the edges crossing a slab do not cross each other in it, so they are
+// sorted by x once and a query is two binary searches, O(log n). When the slabs would hold too many
+// edges (long edges spanning many slabs), a grid is used instead: the inside state of the cell centers
+// is precomputed, and a query checks only the edges of its cell along a path from the center.
+class PolygonLocator
+{
+	std::vector<vec2> v;
+	std::vector<float> ys;					// slab k is ys[k] <= y < ys[k + 1]
+	std::vector<int> slabStart, slabEdges;	// edges of the slabs, ordered by x
+	bool useGrid = false;
+	int gridSize = 0;
+	vec2 lo, hi, cellSize;
+	std::vector<int> cellStart, cellEdges, stamp;
+	std::vector<char> centerInside;
+
+	vec2 A(int e) const { return v[e]; }
+	vec2 B(int e) const { return v[e + 1 < (int)v.size() ? e + 1 : 0]; }
+	static float XAt(vec2 a, vec2 b, float y) { return a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y); }
+	static float YAt(vec2 a, vec2 b, float x) { return a.y + (b.y - a.y) * (x - a.x) / (b.x - a.x); }
+
+	int Slab(float y) const { return int(std::upper_bound(ys.begin(), ys.end(), y) - ys.begin()) - 1; }
+
+	ivec2 Cell(vec2 p) const { return clamp(ivec2((p - lo) / cellSize), ivec2(0), ivec2(gridSize - 1)); }
+	vec2 Center(ivec2 c) const { return lo + (vec2(c) + 0.5f) * cellSize; }
+
+	bool BuildSlabs()
+	{
+		int n = (int)v.size();
+		ys.resize(n);
+		for (int i = 0; i < n; i++) ys[i] = v[i].y;
+		std::sort(ys.begin(), ys.end());
+		ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+
+		// an edge is in the slabs between its lower and upper end, horizontal edges are in none
+		std::vector<int> count(ys.size() + 1, 0);	// differences of the edge counts of consecutive slabs
+		long long total = 0;
+		for (int e = 0; e < n; e++)
+		{
+			int s0 = Slab(std::min(A(e).y, B(e).y)), s1 = Slab(std::max(A(e).y, B(e).y));
+			total += s1 - s0;
+			count[s0]++;
+			count[s1]--;
+		}
+		if (total > 16LL * n + 1024) return false;
+		slabStart.assign(ys.size() + 1, 0);
+		for (size_t k = 0, running = 0; k < ys.size(); k++)
+		{
+			running += count[k];
+			slabStart[k + 1] = slabStart[k] + (int)running;
+		}
+
+		slabEdges.resize(total);
+		std::vector<int> fill(slabStart.begin(), slabStart.end() - 1);
+		for (int e = 0; e < n; e++)
+			for (int k = Slab(std::min(A(e).y, B(e).y)), s1 = Slab(std::max(A(e).y, B(e).y)); k < s1; k++)
+				slabEdges[fill[k]++] = e;
+		for (size_t k = 0; k + 1 < ys.size(); k++)
+		{
+			float y = (ys[k] + ys[k + 1]) * 0.5f;
+			std::sort(slabEdges.begin() + slabStart[k], slabEdges.begin() + slabStart[k + 1], [&](int e0, int e1) {
+				return XAt(A(e0), B(e0), y) < XAt(A(e1), B(e1), y);
+			});
+		}
+		return true;
+	}
+
+	void BuildGrid()
+	{
+		int n = (int)v.size();
+		lo = hi = v[0];
+		for (vec2 p : v) { lo = min(lo, p); hi = max(hi, p); }
+		gridSize = clamp((int)sqrtf((float)n), 1, 512);
+		cellSize = max(hi - lo, vec2(1e-20f)) / float(gridSize);
+
+		// edge e goes into every cell that its bounding box overlaps
+		cellStart.assign(gridSize * gridSize + 1, 0);
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (int e = 0; e < n; e++)
+			{
+				ivec2 c0 = Cell(min(A(e), B(e))), c1 = Cell(max(A(e), B(e)));
+				for (int y = c0.y; y <= c1.y; y++)
+					for (int x = c0.x; x <= c1.x; x++)
+					{
+						if (pass == 0) cellStart[y * gridSize + x + 1]++;
+						else cellEdges[stamp[y * gridSize + x]++] = e;
+					}
+			}
+			if (pass == 0)
+			{
+				for (int k = 0; k < gridSize * gridSize; k++) cellStart[k + 1] += cellStart[k];
+				cellEdges.resize(cellStart.back());
+				stamp.assign(cellStart.begin(), cellStart.end() - 1); // fill positions
+			}
+		}
+
+		// the cell centers of a row: the crossings of the row's line are counted from the left
+		centerInside.assign(gridSize * gridSize, 0);
+		stamp.assign(n, -1);
+		std::vector<float> xs;
+		for (int y = 0; y < gridSize; y++)
+		{
+			float cy = Center(ivec2(0, y)).y;
+			xs.clear();
+			for (int k = cellStart[y * gridSize]; k < cellStart[(y + 1) * gridSize]; k++)
+			{
+				int e = cellEdges[k];
+				if (stamp[e] == y || (A(e).y > cy) == (B(e).y > cy)) continue;
+				stamp[e] = y;
+				xs.push_back(XAt(A(e), B(e), cy));
+			}
+			std::sort(xs.begin(), xs.end());
+			size_t left = 0;
+			for (int x = 0; x < gridSize; x++)
+			{
+				float cx = Center(ivec2(x, y)).x;
+				while (left < xs.size() && xs[left] < cx) left++;
+				centerInside[y * gridSize + x] = left % 2;
+			}
+		}
+	}
+
+public:
+	void Build(const std::vector<vec2>& polygon)
+	{
+		v = polygon;
+		useGrid = v.size() >= 3 && !BuildSlabs();
+		if (useGrid) BuildGrid();
+	}
+
+	bool Inside(vec2 p) const
+	{
+		if (v.size() < 3) return false;
+		if (!useGrid)
+		{
+			// parity of the edges on the left in the slab
+			int k = Slab(p.y);
+			if (k < 0 || k + 1 >= (int)ys.size()) return false;
+			auto first = slabEdges.begin() + slabStart[k], last = slabEdges.begin() + slabStart[k + 1];
+			auto left = std::partition_point(first, last, [&](int e) { return XAt(A(e), B(e), p.y) < p.x; });
+			return (left - first) % 2 == 1;
+		}
+
+		// from the cell center horizontally to (p.x, center.y), then vertically to p;
+		// each crossing is counted with the same half-open rule that gave the state of the center
+		if (p.x < lo.x || p.y < lo.y || p.x > hi.x || p.y > hi.y) return false;
+		ivec2 cell = Cell(p);
+		vec2 c = Center(cell);
+		bool inside = centerInside[cell.y * gridSize + cell.x];
+		for (int k = cellStart[cell.y * gridSize + cell.x]; k < cellStart[cell.y * gridSize + cell.x + 1]; k++)
+		{
+			vec2 a = A(cellEdges[k]), b = B(cellEdges[k]);
+			if ((a.y > c.y) != (b.y > c.y))
+			{
+				float x = XAt(a, b, c.y);
+				if ((x < c.x) != (x < p.x)) inside = !inside;
+			}
+			if ((a.x > p.x) != (b.x > p.x))
+			{
+				float y = YAt(a, b, p.x);
+				if ((y < c.y) != (y < p.y)) inside = !inside;
+			}
+		}
+		return inside;
+	}
+
+	// batch of queries, the results go to inside[i]
+	void Inside(const std::vector<vec2>& points, std::vector<char>& inside) const
+	{
+		inside.resize(points.size());
+		for (size_t i = 0; i < points.size(); i++) inside[i] = Inside(points[i]);
+	}
+};
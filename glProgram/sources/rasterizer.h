@@ -0,0 +1,155 @@
+//=============================================================================================
+// Half-space triangle rasterization of the software renderers, include after framework.h
+//=============================================================================================
+#pragma once
+#include <thread>
+#include <atomic>
+
+//---------------------------
+class HalfSpaceRasterizer {
+//---------------------------
+	// Edge functions in fixed point, evaluated on 8x8 blocks that are trivially accepted or rejected at
+	// their corners. Triangles are binned into screen tiles, and the tiles are rasterized in parallel
+	// (every tile keeps the submission order of its triangles). The derived renderers keep their own
+	// triangles, derived from Edges, and decide what a covered pixel means.
+public:
+	static const int SubPixelBits = 4;		// vertices are snapped to 1/16 pixel
+	static const int BlockSize = 8;
+	static const int TileSize = 64;			// multiple of BlockSize
+	static const int One = 1 << SubPixelBits;
+
+	struct Edges {
+		int minX, minY, maxX, maxY;	// pixel bounding box, clipped to the image
+		int A[3], B[3];				// E(x, y) = A * x + B * y + C, inside if E >= 0
+		long long C[3];
+	};
+
+	template<class F> static void ParallelFor(int nThreads, int n, F&& body) {
+		std::atomic<int> next(0);
+		auto worker = [&] { for (int i = next++; i < n; i = next++) body(i); };
+		std::vector<std::thread> threads;
+		for (int t = 1; t < nThreads; t++) threads.emplace_back(worker);
+		worker();
+		for (std::thread& thread : threads) thread.join();
+	}
+
+protected:
+	int width, height;
+	int tilesX, tilesY;
+	std::vector<std::vector<int>> bins; // triangle indices per tile
+
+	HalfSpaceRasterizer(int _width, int _height) : width(_width), height(_height) {
+		tilesX = (width + TileSize - 1) / TileSize;
+		tilesY = (height + TileSize - 1) / TileSize;
+		bins.resize(tilesX * tilesY);
+	}
+
+	// twice the signed area of the fixed point triangle, positive if it turns clockwise on the screen (y down)
+	static long long Area2(const int X[3], const int Y[3]) {
+		return (long long)(X[1] - X[0]) * (Y[2] - Y[0]) - (long long)(X[2] - X[0]) * (Y[1] - Y[0]);
+	}
+
+	// top-left fill rule: samples exactly on an edge belong to it only if it is a left or top edge,
+	// the C of the other edges is biased by -1
+	static bool TopLeft(int A, int B) { return A > 0 || (A == 0 && B > 0); }
+
+	// the edges of a triangle with positive Area2, false if no pixel sample can be inside;
+	// the vertices have to stay within +-32K pixels (clip beforehand)
+	bool SetupEdges(const int X[3], const int Y[3], Edges& e) const {
+		for (int k = 0; k < 3; k++) {
+			int i = k, j = (k + 1) % 3;
+			e.A[k] = Y[i] - Y[j];
+			e.B[k] = X[j] - X[i];
+			e.C[k] = (long long)X[i] * Y[j] - (long long)Y[i] * X[j];
+			if (!TopLeft(e.A[k], e.B[k])) e.C[k] -= 1;
+		}
+
+		// pixels whose sample point can be inside
+		e.minX = max(0, (std::min({ X[0], X[1], X[2] }) - One / 2 + One - 1) >> SubPixelBits);
+		e.minY = max(0, (std::min({ Y[0], Y[1], Y[2] }) - One / 2 + One - 1) >> SubPixelBits);
+		e.maxX = min(width - 1, (std::max({ X[0], X[1], X[2] }) - One / 2) >> SubPixelBits);
+		e.maxY = min(height - 1, (std::max({ Y[0], Y[1], Y[2] }) - One / 2) >> SubPixelBits);
+		return e.minX <= e.maxX && e.minY <= e.maxY;
+	}
+
+	void Bin(const Edges& e, int index) {
+		for (int ty = e.minY / TileSize; ty <= e.maxY / TileSize; ty++)
+			for (int tx = e.minX / TileSize; tx <= e.maxX / TileSize; tx++)
+				bins[ty * tilesX + tx].push_back(index);
+	}
+
+	// coverage of 8 consecutive pixels by the given edges, bit i set if pixel i is inside
+	static int CoverageMask8(const int* e, const int* a, int nEdges) {
+#ifdef FRAMEWORK_SSE2
+		__m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+		for (int k = 0; k < nEdges; k++) {
+			int step = a[k] * One;
+			__m128i e0 = _mm_setr_epi32(e[k], e[k] + step, e[k] + 2 * step, e[k] + 3 * step);
+			__m128i e1 = _mm_add_epi32(e0, _mm_set1_epi32(4 * step));
+			lo = _mm_or_si128(lo, e0);	// sign bit set if outside of any edge
+			hi = _mm_or_si128(hi, e1);
+		}
+		int outside = _mm_movemask_ps(_mm_castsi128_ps(lo)) | (_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4);
+		return ~outside & 0xFF;
+#else
+		int mask = 0xFF;
+		for (int k = 0; k < nEdges; k++)
+			for (int i = 0; i < 8; i++)
+				if (e[k] + i * a[k] * One < 0) mask &= ~(1 << i);
+		return mask;
+#endif
+	}
+
+	// pixel(x, y) for every covered pixel of the triangle within the rectangle
+	template<class F> static void Rasterize(const Edges& tri, int rectMinX, int rectMinY, int rectMaxX, int rectMaxY, F&& pixel) {
+		int minX = max(tri.minX, rectMinX), maxX = min(tri.maxX, rectMaxX);
+		int minY = max(tri.minY, rectMinY), maxY = min(tri.maxY, rectMaxY);
+		if (minX > maxX || minY > maxY) return;
+
+		const long long span = (long long)(BlockSize - 1) * One;
+		for (int by = minY & ~(BlockSize - 1); by <= maxY; by += BlockSize) {
+			int y0 = max(by, minY), y1 = min(by + BlockSize - 1, maxY);
+			for (int bx = minX & ~(BlockSize - 1); bx <= maxX; bx += BlockSize) {
+				int x0 = max(bx, minX), x1 = min(bx + BlockSize - 1, maxX);
+
+				// edge functions at the corner samples of the block
+				int e[3], a[3], nCrossing = 0;
+				bool rejected = false;
+				for (int k = 0; k < 3 && !rejected; k++) {
+					long long E = tri.A[k] * ((long long)bx * One + One / 2) + tri.B[k] * ((long long)by * One + One / 2) + tri.C[k];
+					long long eMin = E + std::min(0LL, tri.A[k] * span) + std::min(0LL, tri.B[k] * span);
+					long long eMax = E + std::max(0LL, tri.A[k] * span) + std::max(0LL, tri.B[k] * span);
+					if (eMax < 0) rejected = true;
+					else if (eMin < 0) {
+						e[nCrossing] = (int)E;	// small: the edge crosses the block
+						a[nCrossing++] = k;
+					}
+				}
+				if (rejected) continue;
+
+				int ax[3], eRow[3];
+				for (int k = 0; k < nCrossing; k++) {
+					ax[k] = tri.A[a[k]];
+					eRow[k] = e[k] + (y0 - by) * tri.B[a[k]] * One;
+				}
+				for (int y = y0; y <= y1; y++) {
+					int mask = (nCrossing == 0) ? 0xFF : CoverageMask8(eRow, ax, nCrossing);
+					for (int x = x0; x <= x1; x++)
+						if (mask & (1 << (x - bx))) pixel(x, y);
+					for (int k = 0; k < nCrossing; k++)
+						eRow[k] += tri.B[a[k]] * One;
+				}
+			}
+		}
+	}
+
+	// rasterize(index, rectMinX, rectMinY, rectMaxX, rectMaxY) for the binned triangles, one tile at a time per thread
+	template<class F> void FlushTiles(int nThreads, F&& rasterize) {
+		ParallelFor(nThreads, tilesX * tilesY, [&](int tile) {
+			int tx = tile % tilesX, ty = tile / tilesX;
+			for (int index : bins[tile])
+				rasterize(index, tx * TileSize, ty * TileSize, tx * TileSize + TileSize - 1, ty * TileSize + TileSize - 1);
+			bins[tile].clear();
+		});
+	}
+};
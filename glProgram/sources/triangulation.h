@@ -0,0 +1,702 @@
+//=============================================================================================
+// Polygon triangulation engines of the demos, include after framework.h
+//=============================================================================================
+#pragma once
+#include <deque>
+#include <set>
+#include <algorithm>
+#include <float.h>
+
+//---------------------------
+// common interface of the triangulation engines
+class Triangulator
+{
+public:
+	// counterclockwise triangles as indices into the outer vertices followed by the vertices of
+	// the holes; the orientation of the input rings does not matter
+	virtual std::vector<unsigned int> Triangulate(const std::vector<vec2>& outer, const std::vector<std::vector<vec2>>& holes = {}) = 0;
+	virtual ~Triangulator() {}
+};
+
+//---------------------------
+// Ear clipping over a doubly linked vertex list. The holes are bridged into the outer ring first,
+// then ears are cut. Only reflex vertices can be inside an ear: they are kept in a grid whose cells
+// are laid out in z-order (Morton code), so an ear test visits the reflex vertices near the triangle only.
+class EarClipper : public Triangulator
+{
+	struct Node
+	{
+		unsigned int i;							// index of the vertex
+		vec2 p;
+		Node* prev = nullptr, * next = nullptr;	// polygon ring
+		Node* prevZ = nullptr, * nextZ = nullptr; // reflex vertices of the same grid cell
+		int cell = -1;							// -1 if not in the grid
+		Node(unsigned int i, vec2 p) : i(i), p(p) {}
+	};
+	std::deque<Node> nodes; // pointers to the elements stay valid while it grows
+	std::vector<unsigned int> triangles;
+	std::vector<Node*> cells;	// first reflex vertex of each cell, z-order
+	int gridSize = 1;			// cells per side, power of two
+	vec2 bbMin;
+	float invCellSize = 0.0f;
+
+	// > 0 if a, b, c turn left (exact)
+	static int Cross(vec2 a, vec2 b, vec2 c) { return orient2D(a, b, c); }
+	// p is inside or on the counterclockwise triangle abc
+	static bool PointInTriangle(vec2 a, vec2 b, vec2 c, vec2 p)
+	{
+		return Cross(a, b, p) >= 0 && Cross(b, c, p) >= 0 && Cross(c, a, p) >= 0;
+	}
+
+	Node* Insert(unsigned int i, vec2 p, Node* last)
+	{
+		Node* n = &nodes.emplace_back(i, p);
+		if (!last) n->prev = n->next = n;
+		else
+		{
+			n->next = last->next;
+			n->prev = last;
+			last->next->prev = n;
+			last->next = n;
+		}
+		return n;
+	}
+
+	void Remove(Node* n)
+	{
+		n->next->prev = n->prev;
+		n->prev->next = n->next;
+		RemoveFromGrid(n);
+	}
+
+	// ring of vertices with the given orientation
+	Node* Ring(const std::vector<vec2>& v, unsigned int offset, bool counterclockwise)
+	{
+		double area = 0.0;
+		for (size_t k = 0, j = v.size() - 1; k < v.size(); j = k++)
+			area += ((double)v[j].x - v[k].x) * ((double)v[k].y + v[j].y);
+
+		Node* last = nullptr;
+		if (counterclockwise == (area > 0.0))
+			for (size_t k = 0; k < v.size(); k++) last = Insert(offset + (unsigned int)k, v[k], last);
+		else
+			for (size_t k = v.size(); k-- > 0;) last = Insert(offset + (unsigned int)k, v[k], last);
+
+		if (last && last != last->next && last->p == last->next->p)
+		{
+			Remove(last);
+			last = last->next;
+		}
+		return last;
+	}
+
+	// removes duplicate and collinear vertices
+	Node* Filter(Node* start, Node* end = nullptr)
+	{
+		if (!end) end = start;
+		Node* n = start;
+		bool again;
+		do
+		{
+			again = false;
+			if (n->p == n->next->p || Cross(n->prev->p, n->p, n->next->p) == 0)
+			{
+				Remove(n);
+				n = end = n->prev;
+				if (n == n->next) break;
+				again = true;
+			}
+			else n = n->next;
+		} while (again || n != end);
+		return end;
+	}
+
+	// connects a and b with a diagonal (or bridge): two rings, b2 starts the second one
+	Node* Split(Node* a, Node* b)
+	{
+		Node* a2 = &nodes.emplace_back(a->i, a->p);
+		Node* b2 = &nodes.emplace_back(b->i, b->p);
+		Node* an = a->next, * bp = b->prev;
+		a->next = b; b->prev = a;
+		a2->next = an; an->prev = a2;
+		b2->next = a2; a2->prev = b2;
+		bp->next = b2; b2->prev = bp;
+		return b2;
+	}
+
+	// the diagonal from a to b goes inside the polygon near a
+	bool LocallyInside(Node* a, Node* b)
+	{
+		if (Cross(a->prev->p, a->p, a->next->p) > 0)
+			return Cross(a->p, b->p, a->next->p) <= 0 && Cross(a->p, a->prev->p, b->p) <= 0;
+		return Cross(a->p, b->p, a->prev->p) > 0 || Cross(a->p, a->next->p, b->p) > 0;
+	}
+
+	// the middle of the diagonal is inside the polygon (ray casting)
+	bool MiddleInside(Node* a, Node* b)
+	{
+		vec2 m = (a->p + b->p) * 0.5f;
+		bool inside = false;
+		Node* n = a;
+		do
+		{
+			vec2 p = n->p, q = n->next->p;
+			if ((p.y > m.y) != (q.y > m.y) && q.y != p.y && m.x < (q.x - p.x) * (m.y - p.y) / (q.y - p.y) + p.x)
+				inside = !inside;
+			n = n->next;
+		} while (n != a);
+		return inside;
+	}
+
+	static bool Intersects(vec2 p1, vec2 q1, vec2 p2, vec2 q2)
+	{
+		return intersectSegments(p1, q1, p2, q2) != SEGMENTS_DISJOINT;
+	}
+	bool IntersectsPolygon(Node* a, Node* b)
+	{
+		Node* n = a;
+		do
+		{
+			if (n->i != a->i && n->next->i != a->i && n->i != b->i && n->next->i != b->i && Intersects(n->p, n->next->p, a->p, b->p))
+				return true;
+			n = n->next;
+		} while (n != a);
+		return false;
+	}
+
+	bool IsValidDiagonal(Node* a, Node* b)
+	{
+		if (a->next->i == b->i || a->prev->i == b->i || IntersectsPolygon(a, b)) return false;
+		if (LocallyInside(a, b) && LocallyInside(b, a) && MiddleInside(a, b))
+			return Cross(a->prev->p, a->p, b->prev->p) != 0 || Cross(a->p, b->prev->p, b->p) != 0; // no opposite sectors
+		return a->p == b->p && Cross(a->prev->p, a->p, a->next->p) < 0 && Cross(b->prev->p, b->p, b->next->p) < 0;
+	}
+
+	// David Eberly's bridge: a ray to the left from the leftmost hole vertex, then the visible vertex
+	// with the smallest angle to the ray
+	Node* FindHoleBridge(Node* hole, Node* outer)
+	{
+		vec2 h = hole->p;
+		float qx = -FLT_MAX;
+		Node* m = nullptr;
+		Node* n = outer;
+		do
+		{
+			vec2 p = n->p, q = n->next->p;
+			if (h.y <= p.y && h.y >= q.y && q.y != p.y)
+			{
+				float x = p.x + (h.y - p.y) * (q.x - p.x) / (q.y - p.y);
+				if (x <= h.x && x > qx)
+				{
+					qx = x;
+					m = p.x < q.x ? n : n->next;
+					if (x == h.x) return m; // the hole touches the segment
+				}
+			}
+			n = n->next;
+		} while (n != outer);
+		if (!m) return nullptr;
+
+		// reflex vertices in the triangle of the hole vertex, the intersection and the endpoint hide the endpoint
+		Node* stop = m;
+		vec2 mp = m->p;
+		double tanMin = DBL_MAX;
+		n = m;
+		do
+		{
+			vec2 p = n->p;
+			if (h.x >= p.x && p.x >= mp.x && h.x != p.x &&
+				PointInTriangle(vec2(h.y < mp.y ? h.x : qx, h.y), mp, vec2(h.y < mp.y ? qx : h.x, h.y), p))
+			{
+				double tan = fabs((double)h.y - p.y) / ((double)h.x - p.x);
+				if (LocallyInside(n, hole) && (tan < tanMin || (tan == tanMin && (p.x > m->p.x || (p.x == m->p.x && SectorContainsSector(m, n))))))
+				{
+					m = n;
+					tanMin = tan;
+				}
+			}
+			n = n->next;
+		} while (n != stop);
+		return m;
+	}
+
+	// the sector of n is inside the sector of m (they are at the same place)
+	bool SectorContainsSector(Node* m, Node* n)
+	{
+		return Cross(m->prev->p, m->p, n->prev->p) > 0 && Cross(n->next->p, m->p, m->next->p) > 0;
+	}
+
+	Node* EliminateHoles(const std::vector<std::vector<vec2>>& holes, unsigned int offset, Node* outer)
+	{
+		std::vector<Node*> leftmost;
+		for (auto& hole : holes)
+		{
+			Node* ring = hole.size() >= 3 ? Ring(hole, offset, false) : nullptr;
+			offset += (unsigned int)hole.size();
+			if (!ring) continue;
+			Node* l = ring, * n = ring;
+			do
+			{
+				if (n->p.x < l->p.x || (n->p.x == l->p.x && n->p.y < l->p.y)) l = n;
+				n = n->next;
+			} while (n != ring);
+			leftmost.push_back(l);
+		}
+		std::sort(leftmost.begin(), leftmost.end(), [](Node* a, Node* b) { return a->p.x < b->p.x; });
+
+		for (Node* hole : leftmost)
+		{
+			Node* bridge = FindHoleBridge(hole, outer);
+			if (!bridge) continue;
+			Node* bridgeReverse = Split(bridge, hole);
+			Filter(bridgeReverse, bridgeReverse->next);
+			outer = Filter(bridge, bridge->next);
+		}
+		return outer;
+	}
+
+	static unsigned int Interleave(unsigned int x)
+	{
+		x = (x | (x << 8)) & 0x00FF00FF;
+		x = (x | (x << 4)) & 0x0F0F0F0F;
+		x = (x | (x << 2)) & 0x33333333;
+		return (x | (x << 1)) & 0x55555555;
+	}
+	ivec2 CellCoords(vec2 p)
+	{
+		ivec2 c = ivec2((p - bbMin) * invCellSize);
+		return clamp(c, ivec2(0), ivec2(gridSize - 1));
+	}
+	int Cell(ivec2 c) { return (int)(Interleave(c.x) | (Interleave(c.y) << 1)); }
+
+	void RemoveFromGrid(Node* n)
+	{
+		if (n->cell < 0) return;
+		if (n->prevZ) n->prevZ->nextZ = n->nextZ;
+		else cells[n->cell] = n->nextZ;
+		if (n->nextZ) n->nextZ->prevZ = n->prevZ;
+		n->prevZ = n->nextZ = nullptr;
+		n->cell = -1;
+	}
+
+	// puts the reflex vertices of the ring into the grid; a convex vertex never becomes reflex
+	// by cutting ears, so the grid only has to forget vertices
+	void Index(Node* start)
+	{
+		for (Node& n : nodes) { n.prevZ = n.nextZ = nullptr; n.cell = -1; }
+		std::fill(cells.begin(), cells.end(), nullptr);
+		Node* n = start;
+		do
+		{
+			if (Cross(n->prev->p, n->p, n->next->p) <= 0)
+			{
+				n->cell = Cell(CellCoords(n->p));
+				n->nextZ = cells[n->cell];
+				if (n->nextZ) n->nextZ->prevZ = n;
+				cells[n->cell] = n;
+			}
+			n = n->next;
+		} while (n != start);
+	}
+
+	// convex, and no reflex vertex in the triangle
+	bool IsEar(Node* ear)
+	{
+		Node* a = ear->prev, * c = ear->next;
+		if (Cross(a->p, ear->p, c->p) <= 0) return false;
+
+		vec2 lo = min(min(a->p, ear->p), c->p), hi = max(max(a->p, ear->p), c->p);
+		ivec2 c0 = CellCoords(lo), c1 = CellCoords(hi);
+		for (int cy = c0.y; cy <= c1.y; cy++)
+			for (int cx = c0.x; cx <= c1.x; cx++)
+				for (Node* n = cells[Cell(ivec2(cx, cy))], * next; n; n = next)
+				{
+					next = n->nextZ;
+					if (n == a || n == ear || n == c) continue;
+					if (Cross(n->prev->p, n->p, n->next->p) > 0) { RemoveFromGrid(n); continue; } // became convex
+					if (n->p.x >= lo.x && n->p.x <= hi.x && n->p.y >= lo.y && n->p.y <= hi.y && PointInTriangle(a->p, ear->p, c->p, n->p))
+						return false;
+				}
+		return true;
+	}
+
+	// removes zig-zags where two edges cross: a-p-p.next-b becomes the triangle a-p-b
+	Node* CureLocalIntersections(Node* start)
+	{
+		Node* n = start;
+		do
+		{
+			Node* a = n->prev, * b = n->next->next;
+			if (a->p != b->p && Intersects(a->p, n->p, n->next->p, b->p) && LocallyInside(a, b) && LocallyInside(b, a))
+			{
+				triangles.insert(triangles.end(), { a->i, n->i, b->i });
+				Remove(n);
+				Remove(n->next);
+				n = start = b;
+			}
+			n = n->next;
+		} while (n != start);
+		return Filter(n);
+	}
+
+	// last resort: split the polygon along a valid diagonal and triangulate both halves
+	void SplitClip(Node* start)
+	{
+		Node* a = start;
+		do
+		{
+			for (Node* b = a->next->next; b != a->prev; b = b->next)
+			{
+				if (a->i != b->i && IsValidDiagonal(a, b))
+				{
+					Node* c = Split(a, b);
+					a = Filter(a, a->next);
+					c = Filter(c, c->next);
+					Clip(a, 0);
+					Clip(c, 0);
+					return;
+				}
+			}
+			a = a->next;
+		} while (a != start);
+	}
+
+	// passes: 0: plain, 1: without collinear vertices, 2: local intersections cured, then splitting
+	void Clip(Node* ear, int pass)
+	{
+		Index(ear);
+
+		Node* stop = ear;
+		while (ear->prev != ear->next)
+		{
+			Node* prev = ear->prev, * next = ear->next;
+			if (IsEar(ear))
+			{
+				triangles.insert(triangles.end(), { prev->i, ear->i, next->i });
+				Remove(ear);
+				ear = stop = next->next; // skipping the next vertex gives less slivers
+				continue;
+			}
+			ear = next;
+			if (ear == stop) // no ear in a whole round
+			{
+				if (pass == 0) Clip(Filter(ear), 1);
+				else if (pass == 1) Clip(CureLocalIntersections(Filter(ear)), 2);
+				else SplitClip(ear);
+				break;
+			}
+		}
+	}
+
+public:
+	std::vector<unsigned int> Triangulate(const std::vector<vec2>& outer, const std::vector<std::vector<vec2>>& holes = {})
+	{
+		nodes.clear();
+		triangles.clear();
+		if (outer.size() < 3) return triangles;
+
+		Node* ring = Ring(outer, 0, true);
+		if (ring->next == ring->prev) return triangles;
+		ring = EliminateHoles(holes, (unsigned int)outer.size(), ring);
+
+		bbMin = outer[0];
+		vec2 bbMax = outer[0];
+		for (auto& n : nodes) { bbMin = min(bbMin, n.p); bbMax = max(bbMax, n.p); }
+		float size = max(bbMax.x - bbMin.x, bbMax.y - bbMin.y);
+		for (gridSize = 1; gridSize < 1024 && 2 * gridSize * gridSize < (int)nodes.size(); gridSize *= 2);
+		invCellSize = size > 0.0f ? gridSize / size : 0.0f;
+		cells.assign(gridSize * gridSize, nullptr);
+
+		Clip(ring, 0);
+		return triangles;
+	}
+};
+
+//---------------------------
+// Sweep line triangulation in O(n log n): diagonals from the split and merge vertices cut the
+// polygon into y-monotone pieces, which are triangulated one by one in linear time
+class MonotoneTriangulator : public Triangulator
+{
+	enum VertexType { START, END, SPLIT, MERGE, REGULAR };
+
+	std::vector<vec2> p;				// outer vertices, then the vertices of the holes
+	std::vector<unsigned int> id;		// index of the vertex in the input
+	std::vector<int> next, prev;		// rings, counterclockwise around the interior
+	std::vector<std::pair<int, int>> diagonals;
+	std::vector<unsigned int> triangles;
+	double sweepY = 0.0;
+
+	// sweep order: top to bottom, then left to right
+	bool Above(int a, int b) const { return p[a].y > p[b].y || (p[a].y == p[b].y && p[a].x < p[b].x); }
+
+	static int Cross(vec2 a, vec2 b, vec2 c) { return orient2D(a, b, c); }
+
+	// x of edge e (from vertex e to next[e]) at the sweep line
+	double EdgeX(int e) const
+	{
+		int a = e, b = next[e];
+		if (Above(b, a)) std::swap(a, b);
+		if (p[a].y == p[b].y) return p[a].x;
+		double t = ((double)p[a].y - sweepY) / ((double)p[a].y - p[b].y);
+		return p[a].x + t * ((double)p[b].x - p[a].x);
+	}
+
+	// edges crossing the sweep line with the interior on their right, ordered by x
+	struct EdgeLess
+	{
+		using is_transparent = void;
+		const MonotoneTriangulator* t;
+		bool operator()(int a, int b) const
+		{
+			double xa = t->EdgeX(a), xb = t->EdgeX(b);
+			return xa < xb || (xa == xb && a < b);
+		}
+		bool operator()(int a, double x) const { return t->EdgeX(a) < x; }
+		bool operator()(double x, int b) const { return x < t->EdgeX(b); }
+	};
+
+	void AddRing(const std::vector<vec2>& v, unsigned int offset, bool counterclockwise)
+	{
+		// repeated vertices would be neither above nor below each other
+		int first = (int)p.size();
+		for (size_t k = 0; k < v.size(); k++)
+		{
+			if ((int)p.size() > first && p.back() == v[k]) continue;
+			p.push_back(v[k]);
+			id.push_back(offset + (unsigned int)k);
+		}
+		while ((int)p.size() > first + 1 && p.back() == p[first]) { p.pop_back(); id.pop_back(); }
+		int n = (int)p.size() - first;
+		if (n < 3) { p.resize(first); id.resize(first); return; }
+
+		double area = 0.0;
+		for (int k = 0, j = n - 1; k < n; j = k++)
+			area += ((double)p[first + j].x - p[first + k].x) * ((double)p[first + k].y + p[first + j].y);
+		bool forward = counterclockwise == (area > 0.0);
+		for (int k = 0; k < n; k++)
+		{
+			int k1 = first + (k + 1) % n, k0 = first + (k + n - 1) % n;
+			next.push_back(forward ? k1 : k0);
+			prev.push_back(forward ? k0 : k1);
+		}
+	}
+
+	VertexType Type(int v) const
+	{
+		bool prevBelow = Above(v, prev[v]), nextBelow = Above(v, next[v]);
+		bool convex = Cross(p[prev[v]], p[v], p[next[v]]) > 0;
+		if (prevBelow && nextBelow) return convex ? START : SPLIT;
+		if (!prevBelow && !nextBelow) return convex ? END : MERGE;
+		return REGULAR;
+	}
+
+	void MakeMonotone()
+	{
+		int n = (int)p.size();
+		std::vector<int> order(n);
+		for (int v = 0; v < n; v++) order[v] = v;
+		std::sort(order.begin(), order.end(), [&](int a, int b) { return Above(a, b); });
+
+		std::set<int, EdgeLess> status(EdgeLess{ this });
+		std::vector<std::set<int, EdgeLess>::iterator> inStatus(n, status.end());
+		std::vector<int> helper(n, -1);
+		std::vector<VertexType> type(n);
+		for (int v = 0; v < n; v++) type[v] = Type(v);
+
+		auto insert = [&](int e, int v) { inStatus[e] = status.insert(e).first; helper[e] = v; };
+		auto remove = [&](int e) { if (inStatus[e] != status.end()) { status.erase(inStatus[e]); inStatus[e] = status.end(); } };
+		auto fixUp = [&](int v, int e) { if (helper[e] >= 0 && type[helper[e]] == MERGE) diagonals.push_back({ v, helper[e] }); };
+		auto leftOf = [&](int v) {
+			auto it = status.lower_bound((double)p[v].x);
+			return it == status.begin() ? -1 : *std::prev(it); // -1 only for degenerate input
+		};
+
+		for (int v : order)
+		{
+			sweepY = p[v].y;
+			int ePrev = prev[v]; // the edge ending in v
+			switch (type[v])
+			{
+			case START:
+				insert(v, v);
+				break;
+			case END:
+				fixUp(v, ePrev);
+				remove(ePrev);
+				break;
+			case SPLIT:
+			{
+				int e = leftOf(v);
+				if (e >= 0)
+				{
+					diagonals.push_back({ v, helper[e] });
+					helper[e] = v;
+				}
+				insert(v, v);
+				break;
+			}
+			case MERGE:
+			{
+				fixUp(v, ePrev);
+				remove(ePrev);
+				int e = leftOf(v);
+				if (e >= 0)
+				{
+					fixUp(v, e);
+					helper[e] = v;
+				}
+				break;
+			}
+			case REGULAR:
+				if (Above(prev[v], v)) // interior on the right
+				{
+					fixUp(v, ePrev);
+					remove(ePrev);
+					insert(v, v);
+				}
+				else
+				{
+					int e = leftOf(v);
+					if (e >= 0)
+					{
+						fixUp(v, e);
+						helper[e] = v;
+					}
+				}
+				break;
+			}
+		}
+	}
+
+	// the faces of the polygon edges and the diagonals, each as a counterclockwise vertex list
+	std::vector<std::vector<int>> Pieces()
+	{
+		struct HalfEdge { int from, to; bool interior; };
+		std::vector<HalfEdge> edges;
+		for (int v = 0; v < (int)p.size(); v++)
+		{
+			edges.push_back({ v, next[v], true });
+			edges.push_back({ next[v], v, false });
+		}
+		for (auto [a, b] : diagonals)
+		{
+			edges.push_back({ a, b, true });
+			edges.push_back({ b, a, true });
+		}
+
+		// outgoing half-edges of each vertex in counterclockwise order
+		std::vector<std::vector<int>> outgoing(p.size());
+		std::vector<double> angle(edges.size());
+		for (int h = 0; h < (int)edges.size(); h++)
+		{
+			vec2 d = p[edges[h].to] - p[edges[h].from];
+			angle[h] = atan2((double)d.y, (double)d.x);
+			outgoing[edges[h].from].push_back(h);
+		}
+		std::vector<int> slot(edges.size()), twin(edges.size());
+		for (auto& out : outgoing)
+		{
+			std::sort(out.begin(), out.end(), [&](int a, int b) { return angle[a] < angle[b]; });
+			for (int k = 0; k < (int)out.size(); k++) slot[out[k]] = k;
+		}
+		for (int h = 0; h < (int)edges.size(); h += 2) { twin[h] = h + 1; twin[h + 1] = h; }
+
+		// the face on the left continues with the first outgoing edge clockwise from the way back
+		std::vector<std::vector<int>> pieces;
+		std::vector<bool> visited(edges.size(), false);
+		for (int h0 = 0; h0 < (int)edges.size(); h0++)
+		{
+			if (!edges[h0].interior || visited[h0]) continue;
+			std::vector<int> piece;
+			for (int h = h0; !visited[h];)
+			{
+				visited[h] = true;
+				piece.push_back(edges[h].from);
+				auto& out = outgoing[edges[h].to];
+				int back = slot[twin[h]];
+				h = out[(back + out.size() - 1) % out.size()];
+			}
+			pieces.push_back(piece);
+		}
+		return pieces;
+	}
+
+	void Emit(int a, int b, int c)
+	{
+		int area = Cross(p[a], p[b], p[c]);
+		if (area > 0) triangles.insert(triangles.end(), { id[a], id[b], id[c] });
+		else if (area < 0) triangles.insert(triangles.end(), { id[a], id[c], id[b] });
+	}
+
+	// linear time triangulation of a y-monotone piece with a stack of the unfinished vertices
+	void TriangulateMonotone(const std::vector<int>& piece)
+	{
+		int n = (int)piece.size();
+		if (n < 3) return;
+		int top = 0, bottom = 0;
+		for (int k = 1; k < n; k++)
+		{
+			if (Above(piece[k], piece[top])) top = k;
+			if (Above(piece[bottom], piece[k])) bottom = k;
+		}
+
+		// merge the left chain (counterclockwise from the top) and the right chain by sweep order
+		std::vector<std::pair<int, bool>> sorted = { { piece[top], true } }; // vertex, on the left chain
+		sorted.reserve(n);
+		int l = (top + 1) % n, r = (top + n - 1) % n;
+		while (l != bottom || r != bottom)
+		{
+			if (r == bottom || (l != bottom && Above(piece[l], piece[r]))) { sorted.push_back({ piece[l], true }); l = (l + 1) % n; }
+			else { sorted.push_back({ piece[r], false }); r = (r + n - 1) % n; }
+		}
+		sorted.push_back({ piece[bottom], true });
+
+		std::vector<std::pair<int, bool>> stack = { sorted[0], sorted[1] };
+		for (int j = 2; j < n - 1; j++)
+		{
+			auto [u, left] = sorted[j];
+			if (left != stack.back().second)
+			{
+				// opposite chain: fan to every stacked vertex
+				for (size_t k = 0; k + 1 < stack.size(); k++) Emit(u, stack[k].first, stack[k + 1].first);
+				stack = { sorted[j - 1], sorted[j] };
+			}
+			else
+			{
+				// same chain: cut off the triangles while the stacked vertices are convex
+				auto last = stack.back();
+				stack.pop_back();
+				while (!stack.empty())
+				{
+					int s = stack.back().first;
+					int turn = left ? Cross(p[s], p[last.first], p[u]) : Cross(p[u], p[last.first], p[s]);
+					if (turn <= 0) break;
+					Emit(u, last.first, s);
+					last = stack.back();
+					stack.pop_back();
+				}
+				stack.push_back(last);
+				stack.push_back(sorted[j]);
+			}
+		}
+		for (size_t k = 0; k + 1 < stack.size(); k++) Emit(sorted[n - 1].first, stack[k].first, stack[k + 1].first);
+	}
+
+public:
+	std::vector<unsigned int> Triangulate(const std::vector<vec2>& outer, const std::vector<std::vector<vec2>>& holes = {})
+	{
+		p.clear(); id.clear(); next.clear(); prev.clear(); diagonals.clear(); triangles.clear();
+		AddRing(outer, 0, true);
+		if (p.empty()) return triangles;
+		unsigned int offset = (unsigned int)outer.size();
+		for (auto& hole : holes)
+		{
+			AddRing(hole, offset, false);
+			offset += (unsigned int)hole.size();
+		}
+
+		MakeMonotone();
+		for (auto& piece : Pieces()) TriangulateMonotone(piece);
+		return triangles;
+	}
+};